@@ -0,0 +1,150 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "MappingGenerator.h"
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <nlohmann/json.hpp>
+
+#endif
+
+namespace mqtt::bench {
+
+    namespace {
+
+        std::string levelName(std::size_t level, std::size_t rule) {
+            return "l" + std::to_string(level) + "r" + std::to_string(rule);
+        }
+
+        nlohmann::json generateEntry(RuleType ruleType, std::size_t rule, std::size_t entry) {
+            nlohmann::json entryJson = {{"mapped_topic", "bench/out/" + std::to_string(rule) + "/" + std::to_string(entry)},
+                                        {"retain", false},
+                                        {"qos", 0},
+                                        {"delay", -1},
+                                        {"encoding", "text"}};
+
+            switch (ruleType) {
+                case RuleType::STATIC:
+                    entryJson["message_mapping"] = nlohmann::json::array({{{"message", "off"}, {"mapped_message", "0"}},
+                                                                          {{"message", "on"}, {"mapped_message", "1"}}});
+                    break;
+                case RuleType::VALUE:
+                    entryJson["mapping_template"] = "{% if message == \"on\" %}1{% else %}0{% endif %}";
+                    entryJson["suppressions"] = nlohmann::json::array();
+                    break;
+                case RuleType::JSON:
+                    entryJson["mapping_template"] = "{{ message.value * 2 }}";
+                    entryJson["suppressions"] = nlohmann::json::array();
+                    break;
+            }
+
+            return entryJson;
+        }
+
+    } // namespace
+
+    nlohmann::json generateMapping(const MappingShape& mappingShape) {
+        static const char* const ruleTypeNames[] = {"static", "value", "json"};
+
+        nlohmann::json topicLevels = nlohmann::json::array();
+
+        for (std::size_t rule = 0; rule < mappingShape.rules; rule++) {
+            nlohmann::json entries = nlohmann::json::array();
+            for (std::size_t entry = 0; entry < mappingShape.fanOut; entry++) {
+                entries.push_back(generateEntry(mappingShape.ruleType, rule, entry));
+            }
+
+            nlohmann::json topicLevel = {{"name", levelName(mappingShape.levels - 1, rule)},
+                                         {"subscription", {{"qos", 0}, {ruleTypeNames[static_cast<int>(mappingShape.ruleType)], entries}}}};
+
+            for (std::size_t level = mappingShape.levels - 1; level > 0; level--) {
+                topicLevel = {{"name", mappingShape.wildcards ? "+" : levelName(level - 1, rule)}, {"topic_level", topicLevel}};
+            }
+
+            topicLevels.push_back(topicLevel);
+        }
+
+        return {{"meta", {{"revision", 0}}},
+                {"discover_prefix", ""},
+                {"connection",
+                 {{"keep_alive", 60},
+                  {"client_id", "mqttsuite-bench"},
+                  {"clean_session", true},
+                  {"will_topic", ""},
+                  {"will_message", ""},
+                  {"will_qos", 0},
+                  {"will_retain", false},
+                  {"username", ""},
+                  {"password", ""}}},
+                {"mapping", {{"topic_level", topicLevels}}}};
+    }
+
+    std::string generateTopic(const MappingShape& mappingShape, std::size_t rule) {
+        std::string topic;
+
+        for (std::size_t level = 0; level < mappingShape.levels; level++) {
+            topic += (level > 0 ? "/" : "") + levelName(level, rule);
+        }
+
+        return topic;
+    }
+
+    std::string generateMessage(RuleType ruleType) {
+        return ruleType == RuleType::JSON ? generateJsonPayload(1) : "on";
+    }
+
+    std::string generateJsonPayload(std::size_t fields) {
+        nlohmann::ordered_json payload = nlohmann::ordered_json::object();
+
+        for (std::size_t field = 0; field < fields; field++) {
+            if (field == fields / 2) {
+                payload["value"] = 21;
+            } else {
+                payload["field" + std::to_string(field)] = {
+                    {"reading", static_cast<double>(field) * 0.5}, {"unit", "C"}, {"history", {1, 2, 3, 4}}};
+            }
+        }
+
+        return payload.dump();
+    }
+
+} // namespace mqtt::bench
@@ -0,0 +1,81 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTSUITE_BENCH_MAPPINGGENERATOR_H
+#define MQTTSUITE_BENCH_MAPPINGGENERATOR_H
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <cstddef>
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+namespace mqtt::bench {
+
+    enum class RuleType { STATIC, VALUE, JSON };
+
+    // Shape of a synthetic mapping: 'rules' subscriptions, each 'levels' topic levels deep and carrying 'fanOut' mapping
+    // entries. With 'wildcards' all but the last topic level are '+', so matching has to descend into every branch.
+    struct MappingShape {
+        std::size_t levels = 1;
+        std::size_t rules = 1;
+        std::size_t fanOut = 1;
+        RuleType ruleType = RuleType::VALUE;
+        bool wildcards = false;
+    };
+
+    // All mapping_commons defaults are spelled out, so the generated mapping is complete even without the default patch
+    nlohmann::json generateMapping(const MappingShape& mappingShape);
+
+    // Topic of the subscription 'rule' - the last rule is the most expensive one to match
+    std::string generateTopic(const MappingShape& mappingShape, std::size_t rule);
+
+    // Payload matched by the mapping entries of the given rule type
+    std::string generateMessage(RuleType ruleType);
+
+    // JSON object with 'fields' numeric fields; the field "value" referenced by the generated json rules sits in the middle
+    std::string generateJsonPayload(std::size_t fields);
+
+} // namespace mqtt::bench
+
+#endif // MQTTSUITE_BENCH_MAPPINGGENERATOR_H
@@ -0,0 +1,199 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "AllocationCounter.h"
+#include "MappingGenerator.h"
+#include "lib/MqttMapper.h"
+
+#include <iot/mqtt/packets/Publish.h>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <string>
+
+#endif
+
+namespace {
+
+    using mqtt::bench::MappingShape;
+    using mqtt::bench::RuleType;
+
+    // Set as soon as one getMappings benchmark exceeds its allocation budget; turns into a non-zero exit code
+    bool allocationBudgetExceeded = false;
+
+    // maxAllocsPerMsg: budget of global operator new calls per getMappings call. The budgets keep at least 20 % headroom over the
+    // counts measured with the template cache in place, so a regression of the cache (templates parsed per message again, about
+    // twice the count) fails the run.
+    void runGetMappings(benchmark::State& state, const MappingShape& mappingShape, const std::string& message, double maxAllocsPerMsg) {
+        mqtt::lib::MqttMapper mqttMapper;
+        mqttMapper.setMapping(mqtt::bench::generateMapping(mappingShape));
+
+        const iot::mqtt::packets::Publish publish(
+            0, mqtt::bench::generateTopic(mappingShape, mappingShape.rules - 1), message, 0, false, false);
+
+        benchmark::DoNotOptimize(mqttMapper.getMappings(publish)); // warm up: templates are parsed on first use
+
+        std::size_t mappedCount = 0;
+        const std::uint64_t allocationsBefore = mqtt::bench::allocationCount();
+        for ([[maybe_unused]] auto _ : state) {
+            const mqtt::lib::MqttMapper::MappedPublishes mappedPublishes = mqttMapper.getMappings(publish);
+            mappedCount += std::get<0>(mappedPublishes).size();
+
+            benchmark::DoNotOptimize(mappedPublishes);
+        }
+        const std::uint64_t allocations = mqtt::bench::allocationCount() - allocationsBefore;
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+        state.counters["mapped"] = benchmark::Counter(static_cast<double>(mappedCount), benchmark::Counter::kIsRate);
+        state.counters["allocs_per_msg"] = benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+
+        const double allocsPerMsg = static_cast<double>(allocations) / static_cast<double>(state.iterations());
+        if (allocsPerMsg > maxAllocsPerMsg) {
+            allocationBudgetExceeded = true;
+
+            const std::string error =
+                "allocs_per_msg " + std::to_string(allocsPerMsg) + " exceeds the budget of " + std::to_string(maxAllocsPerMsg);
+            state.SkipWithError(error.c_str());
+        }
+    }
+
+    // Rule count, matching the last rule
+    void BM_GetMappings_Static(benchmark::State& state) {
+        const MappingShape mappingShape{.levels = 3, .rules = static_cast<std::size_t>(state.range(0)), .ruleType = RuleType::STATIC};
+
+        runGetMappings(state, mappingShape, mqtt::bench::generateMessage(RuleType::STATIC), 8);
+    }
+    BENCHMARK(BM_GetMappings_Static)->RangeMultiplier(8)->Range(1, 1 << 12);
+
+    void BM_GetMappings_Value(benchmark::State& state) {
+        const MappingShape mappingShape{.levels = 3, .rules = static_cast<std::size_t>(state.range(0)), .ruleType = RuleType::VALUE};
+
+        runGetMappings(state, mappingShape, mqtt::bench::generateMessage(RuleType::VALUE), 48);
+    }
+    BENCHMARK(BM_GetMappings_Value)->RangeMultiplier(8)->Range(1, 1 << 12);
+
+    void BM_GetMappings_Json(benchmark::State& state) {
+        const MappingShape mappingShape{.levels = 3, .rules = static_cast<std::size_t>(state.range(0)), .ruleType = RuleType::JSON};
+
+        runGetMappings(state, mappingShape, mqtt::bench::generateMessage(RuleType::JSON), 60);
+    }
+    BENCHMARK(BM_GetMappings_Json)->RangeMultiplier(8)->Range(1, 1 << 12);
+
+    // All inner levels are '+': every branch is descended before the last rule matches
+    void BM_GetMappings_Wildcard(benchmark::State& state) {
+        const MappingShape mappingShape{
+            .levels = 4, .rules = static_cast<std::size_t>(state.range(0)), .ruleType = RuleType::VALUE, .wildcards = true};
+
+        runGetMappings(state, mappingShape, mqtt::bench::generateMessage(RuleType::VALUE), 48);
+    }
+    BENCHMARK(BM_GetMappings_Wildcard)->RangeMultiplier(8)->Range(1, 1 << 12);
+
+    // Topic depth
+    void BM_GetMappings_Deep(benchmark::State& state) {
+        const MappingShape mappingShape{.levels = static_cast<std::size_t>(state.range(0)), .rules = 16, .ruleType = RuleType::VALUE};
+
+        runGetMappings(state, mappingShape, mqtt::bench::generateMessage(RuleType::VALUE), 48);
+    }
+    BENCHMARK(BM_GetMappings_Deep)->RangeMultiplier(2)->Range(1, 64);
+
+    // Mapping entries rendered per matching publish
+    void BM_GetMappings_FanOut(benchmark::State& state) {
+        const MappingShape mappingShape{
+            .levels = 3, .rules = 16, .fanOut = static_cast<std::size_t>(state.range(0)), .ruleType = RuleType::JSON};
+
+        runGetMappings(state, mappingShape, mqtt::bench::generateMessage(RuleType::JSON), 32 + 28 * static_cast<double>(state.range(0)));
+    }
+    BENCHMARK(BM_GetMappings_FanOut)->RangeMultiplier(4)->Range(1, 256);
+
+    // Payload size in fields for a json rule referencing a single field: the unreferenced fields must not allocate
+    void BM_GetMappings_JsonPayload(benchmark::State& state) {
+        const MappingShape mappingShape{.levels = 3, .rules = 16, .ruleType = RuleType::JSON};
+        const std::string payload = mqtt::bench::generateJsonPayload(static_cast<std::size_t>(state.range(0)));
+
+        runGetMappings(state, mappingShape, payload, 60);
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * payload.size()));
+    }
+    BENCHMARK(BM_GetMappings_JsonPayload)->RangeMultiplier(8)->Range(1, 1 << 12);
+
+    // Mapping size in rules
+    void BM_SetMapping(benchmark::State& state) {
+        const nlohmann::json mappingJson =
+            mqtt::bench::generateMapping({.levels = 3, .rules = static_cast<std::size_t>(state.range(0)), .ruleType = RuleType::JSON});
+
+        mqtt::lib::MqttMapper mqttMapper;
+        for ([[maybe_unused]] auto _ : state) {
+            benchmark::DoNotOptimize(mqttMapper.setMapping(mappingJson));
+        }
+
+        state.SetComplexityN(state.range(0));
+    }
+    BENCHMARK(BM_SetMapping)->RangeMultiplier(8)->Range(1, 1 << 12)->Complexity();
+
+    void BM_Validate(benchmark::State& state) {
+        const nlohmann::json mappingJson =
+            mqtt::bench::generateMapping({.levels = 3, .rules = static_cast<std::size_t>(state.range(0)), .ruleType = RuleType::JSON});
+
+        for ([[maybe_unused]] auto _ : state) {
+            benchmark::DoNotOptimize(mqtt::lib::MqttMapper::validate(mappingJson));
+        }
+
+        state.SetComplexityN(state.range(0));
+    }
+    BENCHMARK(BM_Validate)->RangeMultiplier(8)->Range(1, 1 << 12)->Complexity();
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return allocationBudgetExceeded ? 1 : 0;
+}
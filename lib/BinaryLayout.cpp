@@ -0,0 +1,152 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "BinaryLayout.h"
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+#endif
+
+namespace mqtt::lib {
+
+    namespace {
+
+        template <typename ValueT, std::endian byteOrder>
+        void decodeField(const char* data, double scale, bool scaled, nlohmann::json& value) {
+            std::array<char, sizeof(ValueT)> bytes;
+            std::memcpy(bytes.data(), data, sizeof(ValueT));
+
+            if constexpr (byteOrder != std::endian::native) {
+                std::reverse(bytes.begin(), bytes.end());
+            }
+
+            const ValueT rawValue = std::bit_cast<ValueT>(bytes);
+
+            if (scaled) {
+                value = static_cast<double>(rawValue) * scale;
+            } else {
+                value = rawValue;
+            }
+        }
+
+        template <std::endian byteOrder>
+        std::pair<void (*)(const char*, double, bool, nlohmann::json&), std::size_t> selectFieldDecoder(const std::string& type) {
+            if (type == "int8") {
+                return {decodeField<std::int8_t, byteOrder>, sizeof(std::int8_t)};
+            }
+            if (type == "uint8") {
+                return {decodeField<std::uint8_t, byteOrder>, sizeof(std::uint8_t)};
+            }
+            if (type == "int16") {
+                return {decodeField<std::int16_t, byteOrder>, sizeof(std::int16_t)};
+            }
+            if (type == "uint16") {
+                return {decodeField<std::uint16_t, byteOrder>, sizeof(std::uint16_t)};
+            }
+            if (type == "int32") {
+                return {decodeField<std::int32_t, byteOrder>, sizeof(std::int32_t)};
+            }
+            if (type == "uint32") {
+                return {decodeField<std::uint32_t, byteOrder>, sizeof(std::uint32_t)};
+            }
+            if (type == "int64") {
+                return {decodeField<std::int64_t, byteOrder>, sizeof(std::int64_t)};
+            }
+            if (type == "uint64") {
+                return {decodeField<std::uint64_t, byteOrder>, sizeof(std::uint64_t)};
+            }
+            if (type == "float32") {
+                return {decodeField<float, byteOrder>, sizeof(float)};
+            }
+            if (type == "float64") {
+                return {decodeField<double, byteOrder>, sizeof(double)};
+            }
+
+            throw std::runtime_error("Unsupported binary field type: " + type);
+        }
+
+    } // namespace
+
+    BinaryLayout::BinaryLayout(const nlohmann::json& binaryJson) {
+        const bool bigEndian = binaryJson.value("byte_order", "little") == "big";
+
+        for (const nlohmann::json& fieldJson : binaryJson["layout"]) {
+            const std::string type = fieldJson["type"];
+
+            const auto [decoder, fieldSize] =
+                bigEndian ? selectFieldDecoder<std::endian::big>(type) : selectFieldDecoder<std::endian::little>(type);
+
+            Field field{fieldJson["name"], fieldJson["offset"], fieldJson.value("scale", 1.0), fieldJson.contains("scale"), decoder};
+
+            size = std::max(size, field.offset + fieldSize);
+            fields.push_back(std::move(field));
+        }
+    }
+
+    bool BinaryLayout::decode(const std::string& payload, nlohmann::json& message) const {
+        bool success = false;
+
+        if (payload.size() >= size) {
+            message = nlohmann::json::object();
+
+            for (const Field& field : fields) {
+                field.decoder(payload.data() + field.offset, field.scale, field.scaled, message[field.name]);
+            }
+
+            success = true;
+        }
+
+        return success;
+    }
+
+    std::size_t BinaryLayout::getSize() const {
+        return size;
+    }
+
+} // namespace mqtt::lib
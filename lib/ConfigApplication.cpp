@@ -41,15 +41,18 @@
 
 #include "ConfigApplication.h"
 
+#include "MappingNamespace.h"
 #include "MqttMapper.h"
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
 #include "log/Logger.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <exception>
-#include <fstream>
 #include <map>
+#include <nlohmann/json.hpp>
 #include <stdexcept>
 
 #endif
@@ -59,16 +62,17 @@ namespace mqtt::lib {
     template <typename ConcretConfigApplication>
     ConfigApplication::ConfigApplication(utils::SubCommand* parent, ConcretConfigApplication* concretConfigApplication)
         : utils::SubCommand(parent, concretConfigApplication, "Applications")
-        , mqttMapper(std::make_shared<MqttMapper>())
+        , mappingNamespaces(std::make_shared<MappingNamespaces>(
+              std::make_shared<MappingNamespace>(std::string(ConcretConfigApplication::NAME), true)))
         , mappingFileOpt(        //
               addOptionFunction( //
                   "--mqtt-mapping-file",
                   [this](const std::string& mappFilename) {
                       try {
-                          this->mappFilename = mappFilename;
-                          loadMapping();
+                          getDefaultMappingNamespace()->setMappingFile(mappFilename);
+                          getDefaultMappingNamespace()->loadMapping();
                       } catch (std::runtime_error& e) {
-                          this->mappFilename.clear();
+                          getDefaultMappingNamespace()->setMappingFile("");
 
                           throw CLI::ValidationError(
                               getName(), std::string("Activating mapping description in '" + mappFilename + "' failed\nWhat: " + e.what()));
@@ -83,7 +87,25 @@ namespace mqtt::lib {
                   "--mqtt-session-store",
                   "Path to file for the persistent session store",
                   "filename",
-                  !CLI::ExistingDirectory)) {
+                  !CLI::ExistingDirectory))
+        , mapperThreadsOpt(      //
+              addOptionFunction( //
+                  "--mapper-threads",
+                  [this](const std::string& mapperThreads) {
+                      for (const std::shared_ptr<MappingNamespace>& mappingNamespace : mappingNamespaces->getAll()) {
+                          mappingNamespace->getMqttMapper()->setWorkerThreads(std::stoul(mapperThreads));
+                      }
+                  },
+                  "Number of worker threads evaluating the mapping, per mapping namespace (0 = on the event loop)",
+                  "number",
+                  CLI::NonNegativeNumber))
+        , loopReportOpt( //
+              addFlag(   //
+                  "--loop-report{true}",
+                  "Publish the event loop statistics to $SYS/mqttsuite/<application>/loop every 10 s",
+                  "bool",
+                  "true",
+                  CLI::IsMember({"true", "false"}))) {
     }
 
     ConfigApplication::~ConfigApplication() = default;
@@ -104,73 +126,40 @@ namespace mqtt::lib {
         return this;
     }
 
-    bool ConfigApplication::persistMapping() const {
-        bool success = false;
-
-        std::ofstream mapFile(mappFilename, std::ios::trunc);
-        if (mapFile.is_open()) {
-            try {
-                mapFile << mqttMapper->getMapping().dump(2);
-                mapFile.close();
-
-                VLOG(1) << "Write mapping file seccess";
-
-                success = true;
-            } catch (const std::exception& e) {
-                mapFile.close();
-
-                VLOG(1) << "Write mapping file failed: " << e.what();
-            }
-        } else {
-            VLOG(1) << "Cannot open mapping file for writing: " << mappFilename;
-        }
+    ConfigApplication& ConfigApplication::setLoopReport(bool loopReport) {
+        setDefaultValue(loopReportOpt, loopReport);
 
-        return success;
+        return *this;
     }
 
-    bool ConfigApplication::loadMapping() const {
-        bool success = false;
-
-        if (!mappFilename.empty()) {
-            std::ifstream mapFile(mappFilename);
-
-            if (mapFile.is_open()) {
-                VLOG(1) << "Mapping file: " << mappFilename;
-
-                try {
-                    nlohmann::json mappingJson;
-                    mapFile >> mappingJson;
-
-                    mqttMapper->setMapping(mappingJson);
-
-                    VLOG(1) << "Load mapping file success";
+    bool ConfigApplication::getLoopReport() const {
+        return loopReportOpt->as<bool>();
+    }
 
-                    success = true;
-                } catch (const std::exception& e) {
-                    VLOG(1) << "Load mapping file failed: " << e.what() << " at " << mapFile.tellg();
-                }
+    bool ConfigApplication::persistMapping() const {
+        return getDefaultMappingNamespace()->persistMapping();
+    }
 
-                mapFile.close();
-            } else {
-                VLOG(1) << "Mapping file: " << mappFilename << " not found";
-            }
-        }
+    const std::shared_ptr<MqttMapper> ConfigApplication::getMqttMapper() const {
+        return getDefaultMappingNamespace()->getMqttMapper();
+    }
 
-        return success;
+    const std::shared_ptr<MappingNamespace>& ConfigApplication::getDefaultMappingNamespace() const {
+        return mappingNamespaces->getDefault();
     }
 
-    const std::shared_ptr<MqttMapper> ConfigApplication::getMqttMapper() const {
-        return mqttMapper;
+    const std::shared_ptr<MappingNamespaces>& ConfigApplication::getMappingNamespaces() const {
+        return mappingNamespaces;
     }
 
     ConfigApplication* ConfigApplication::setMapping(const std::string& mapping) {
-        mqttMapper->setMapping(nlohmann::json::parse(mapping));
+        getDefaultMappingNamespace()->setMapping(nlohmann::json::parse(mapping));
 
         return this;
     }
 
     std::string ConfigApplication::getMapping(int indent) const {
-        return mqttMapper->getMapping().dump(indent);
+        return getMqttMapper()->getMapping().dump(indent);
     }
 
     ConfigMqttBroker::ConfigMqttBroker(utils::SubCommand* parent)
@@ -180,7 +169,56 @@ namespace mqtt::lib {
                   "--html-root",
                   "HTML root directory",
                   "directory",
-                  CLI::ExistingDirectory)) {
+                  CLI::ExistingDirectory))
+        , eventLogLevelOpt( //
+              addOption(    //
+                  "--event-log-level",
+                  "Verbose log level at which server sent events are logged",
+                  "level",
+                  "2",
+                  CLI::NonNegativeNumber))
+        , eventBatchWindowOpt( //
+              addOption(       //
+                  "--event-batch-window",
+                  "Milliseconds server sent events are collected and coalesced before they are sent as one write (0 = send immediately)",
+                  "ms",
+                  "0",
+                  CLI::NonNegativeNumber))
+        , eventReceiverBudgetOpt( //
+              addOption(          //
+                  "--event-receiver-budget",
+                  "Bytes of server sent events a dashboard connection may have queued but not yet sent (0 = unlimited)",
+                  "bytes",
+                  "1048576",
+                  CLI::NonNegativeNumber))
+        , eventReceiverOverflowOpt( //
+              addOption(            //
+                  "--event-receiver-overflow",
+                  "What to do with a dashboard connection exceeding its budget",
+                  "policy",
+                  "snapshot",
+                  CLI::IsMember({"snapshot", "disconnect"})))
+        , eventReplaySizeOpt( //
+              addOption(      //
+                  "--event-replay-size",
+                  "Number of recent server sent events kept to resume reconnecting dashboards without a snapshot (0 = disabled)",
+                  "number",
+                  "1024",
+                  CLI::NonNegativeNumber))
+        , trafficStatsCapacityOpt( //
+              addOption(           //
+                  "--traffic-stats-capacity",
+                  "Number of topics and of clients tracked as heavy hitters of the publish traffic (0 = disabled)",
+                  "number",
+                  "100",
+                  CLI::NonNegativeNumber))
+        , sysIntervalOpt( //
+              addOption(  //
+                  "--sys-interval",
+                  "Seconds between updates of the retained $SYS/broker statistics topics (0 = disabled)",
+                  "seconds",
+                  "10",
+                  CLI::NonNegativeNumber)) {
         required(htmlRootOpt);
     }
 
@@ -199,10 +237,251 @@ namespace mqtt::lib {
         return htmlRootOpt->as<std::string>();
     }
 
+    ConfigMqttBroker& ConfigMqttBroker::setEventLogLevel(int eventLogLevel) {
+        setDefaultValue(eventLogLevelOpt, eventLogLevel);
+
+        return *this;
+    }
+
+    int ConfigMqttBroker::getEventLogLevel() const {
+        return eventLogLevelOpt->as<int>();
+    }
+
+    ConfigMqttBroker& ConfigMqttBroker::setEventBatchWindow(std::size_t eventBatchWindow) {
+        setDefaultValue(eventBatchWindowOpt, eventBatchWindow);
+
+        return *this;
+    }
+
+    std::size_t ConfigMqttBroker::getEventBatchWindow() const {
+        return eventBatchWindowOpt->as<std::size_t>();
+    }
+
+    ConfigMqttBroker& ConfigMqttBroker::setEventReceiverBudget(std::size_t eventReceiverBudget) {
+        setDefaultValue(eventReceiverBudgetOpt, eventReceiverBudget);
+
+        return *this;
+    }
+
+    std::size_t ConfigMqttBroker::getEventReceiverBudget() const {
+        return eventReceiverBudgetOpt->as<std::size_t>();
+    }
+
+    ConfigMqttBroker& ConfigMqttBroker::setEventReceiverOverflow(const std::string& eventReceiverOverflow) {
+        setDefaultValue(eventReceiverOverflowOpt, eventReceiverOverflow);
+
+        return *this;
+    }
+
+    std::string ConfigMqttBroker::getEventReceiverOverflow() const {
+        return eventReceiverOverflowOpt->as<std::string>();
+    }
+
+    ConfigMqttBroker& ConfigMqttBroker::setEventReplaySize(std::size_t eventReplaySize) {
+        setDefaultValue(eventReplaySizeOpt, eventReplaySize);
+
+        return *this;
+    }
+
+    std::size_t ConfigMqttBroker::getEventReplaySize() const {
+        return eventReplaySizeOpt->as<std::size_t>();
+    }
+
+    ConfigMqttBroker& ConfigMqttBroker::setTrafficStatsCapacity(std::size_t trafficStatsCapacity) {
+        setDefaultValue(trafficStatsCapacityOpt, trafficStatsCapacity);
+
+        return *this;
+    }
+
+    std::size_t ConfigMqttBroker::getTrafficStatsCapacity() const {
+        return trafficStatsCapacityOpt->as<std::size_t>();
+    }
+
+    ConfigMqttBroker& ConfigMqttBroker::setSysInterval(double sysInterval) {
+        setDefaultValue(sysIntervalOpt, sysInterval);
+
+        return *this;
+    }
+
+    double ConfigMqttBroker::getSysInterval() const {
+        return sysIntervalOpt->as<double>();
+    }
+
     ConfigMqttIntegrator::ConfigMqttIntegrator(utils::SubCommand* parent)
-        : ConfigApplication(parent, this) {
+        : ConfigApplication(parent, this)
+        , mappingNamespacesOpt(  //
+              addOptionFunction( //
+                  "--mqtt-mapping-namespaces",
+                  [this](const std::string& namespaceList) {
+                      for (std::size_t pos = 0; pos < namespaceList.size();) {
+                          const std::size_t comma = std::min(namespaceList.find(',', pos), namespaceList.size());
+                          const std::string entry = namespaceList.substr(pos, comma - pos);
+                          pos = comma + 1;
+
+                          const std::size_t equal = entry.find('=');
+                          if (equal == 0 || equal == std::string::npos || equal + 1 == entry.size()) {
+                              throw CLI::ValidationError(getName(), "Mapping namespace '" + entry + "' is not of the form name=filename");
+                          }
+
+                          const std::shared_ptr<MappingNamespace> mappingNamespace =
+                              std::make_shared<MappingNamespace>(entry.substr(0, equal), false);
+                          mappingNamespace->setMappingFile(entry.substr(equal + 1));
+                          mappingNamespace->getMqttMapper()->setWorkerThreads(getMqttMapper()->getWorkerThreads());
+
+                          try {
+                              mappingNamespaces->add(mappingNamespace);
+                          } catch (const std::runtime_error& e) {
+                              throw CLI::ValidationError(getName(), e.what());
+                          }
+
+                          if (!mappingNamespace->loadMapping()) {
+                              throw CLI::ValidationError(getName(),
+                                                         "Activating mapping namespace '" + mappingNamespace->getName() + "' from '" +
+                                                             mappingNamespace->getMappingFile() + "' failed");
+                          }
+                      }
+                  },
+                  "Additional mapping namespaces sharing the upstream connection",
+                  "name=filename[,name=filename...]",
+                  CLI::TypeValidator<std::string>()))
+        , shardsOpt(     //
+              addOption( //
+                  "--mqtt-shards",
+                  "Number of upstream connections per client instance, each subscribing to a hash-partitioned share of the subscriptions",
+                  "number",
+                  "1",
+                  CLI::PositiveNumber))
+        , inflightWindowOpt( //
+              addOption(     //
+                  "--mqtt-inflight-window",
+                  "Maximum number of unacknowledged QoS 1/2 publishes per connection (0 = unlimited)",
+                  "number",
+                  "0",
+                  CLI::NonNegativeNumber))
+        , sendQueueOpt(  //
+              addOption( //
+                  "--mqtt-send-queue",
+                  "Capacity of the queue holding publishes waiting for a free inflight slot (0 = unbounded)",
+                  "number",
+                  "10000",
+                  CLI::NonNegativeNumber))
+        , overflowPolicyOpt( //
+              addOption(     //
+                  "--mqtt-overflow-policy",
+                  "What to do with a publish when the send queue is full",
+                  "policy",
+                  "drop-oldest",
+                  CLI::IsMember({"drop-oldest", "drop-new"})))
+        , outboxOpt(     //
+              addOption( //
+                  "--mqtt-outbox",
+                  "File persisting QoS 1/2 publishes while the upstream connection is down (empty = disabled)",
+                  "filename",
+                  "",
+                  CLI::TypeValidator<std::string>()))
+        , outboxSizeOpt( //
+              addOption( //
+                  "--mqtt-outbox-size",
+                  "Capacity of the outbox in bytes",
+                  "bytes",
+                  "16777216",
+                  CLI::PositiveNumber))
+        , outboxPolicyOpt( //
+              addOption(   //
+                  "--mqtt-outbox-policy",
+                  "What to do with a publish when the outbox is full",
+                  "policy",
+                  "drop-oldest",
+                  CLI::IsMember({"drop-oldest", "drop-new"})))
+        , outboxDrainRateOpt( //
+              addOption(      //
+                  "--mqtt-outbox-drain-rate",
+                  "Publishes per second replayed from the outbox after reconnect",
+                  "number",
+                  "100",
+                  CLI::PositiveNumber)) {
     }
 
     ConfigMqttIntegrator::~ConfigMqttIntegrator() = default;
 
+    ConfigMqttIntegrator& ConfigMqttIntegrator::setShards(std::size_t shards) {
+        setDefaultValue(shardsOpt, shards);
+
+        return *this;
+    }
+
+    std::size_t ConfigMqttIntegrator::getShards() const {
+        return shardsOpt->as<std::size_t>();
+    }
+
+    ConfigMqttIntegrator& ConfigMqttIntegrator::setInflightWindow(std::size_t inflightWindow) {
+        setDefaultValue(inflightWindowOpt, inflightWindow);
+
+        return *this;
+    }
+
+    std::size_t ConfigMqttIntegrator::getInflightWindow() const {
+        return inflightWindowOpt->as<std::size_t>();
+    }
+
+    ConfigMqttIntegrator& ConfigMqttIntegrator::setSendQueue(std::size_t sendQueue) {
+        setDefaultValue(sendQueueOpt, sendQueue);
+
+        return *this;
+    }
+
+    std::size_t ConfigMqttIntegrator::getSendQueue() const {
+        return sendQueueOpt->as<std::size_t>();
+    }
+
+    ConfigMqttIntegrator& ConfigMqttIntegrator::setOverflowPolicy(const std::string& overflowPolicy) {
+        setDefaultValue(overflowPolicyOpt, overflowPolicy);
+
+        return *this;
+    }
+
+    std::string ConfigMqttIntegrator::getOverflowPolicy() const {
+        return overflowPolicyOpt->as<std::string>();
+    }
+
+    ConfigMqttIntegrator& ConfigMqttIntegrator::setOutbox(const std::string& outbox) {
+        setDefaultValue(outboxOpt, outbox);
+
+        return *this;
+    }
+
+    std::string ConfigMqttIntegrator::getOutbox() const {
+        return outboxOpt->as<std::string>();
+    }
+
+    ConfigMqttIntegrator& ConfigMqttIntegrator::setOutboxSize(std::size_t outboxSize) {
+        setDefaultValue(outboxSizeOpt, outboxSize);
+
+        return *this;
+    }
+
+    std::size_t ConfigMqttIntegrator::getOutboxSize() const {
+        return outboxSizeOpt->as<std::size_t>();
+    }
+
+    ConfigMqttIntegrator& ConfigMqttIntegrator::setOutboxPolicy(const std::string& outboxPolicy) {
+        setDefaultValue(outboxPolicyOpt, outboxPolicy);
+
+        return *this;
+    }
+
+    std::string ConfigMqttIntegrator::getOutboxPolicy() const {
+        return outboxPolicyOpt->as<std::string>();
+    }
+
+    ConfigMqttIntegrator& ConfigMqttIntegrator::setOutboxDrainRate(std::size_t outboxDrainRate) {
+        setDefaultValue(outboxDrainRateOpt, outboxDrainRate);
+
+        return *this;
+    }
+
+    std::size_t ConfigMqttIntegrator::getOutboxDrainRate() const {
+        return outboxDrainRateOpt->as<std::size_t>();
+    }
+
 } // namespace mqtt::lib
@@ -43,13 +43,16 @@
 #define APPS_MQTTBROKER_MQTTBRIDGE_CONFIGBRIDGE_H
 
 namespace mqtt::lib {
+    class MappingNamespace;
+    class MappingNamespaces;
     class MqttMapper;
-}
+} // namespace mqtt::lib
 
 #include <utils/SubCommand.h>
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
+#include <cstddef>
 #include <memory>
 #include <nlohmann/json_fwd.hpp>
 #include <string>
@@ -75,17 +78,19 @@ namespace mqtt::lib {
 
         bool persistMapping() const;
 
-    private:
-        bool loadMapping() const;
+        ConfigApplication& setLoopReport(bool loopReport);
+        bool getLoopReport() const;
+
+        const std::shared_ptr<MappingNamespace>& getDefaultMappingNamespace() const;
+        const std::shared_ptr<MappingNamespaces>& getMappingNamespaces() const;
 
     protected:
-        std::shared_ptr<MqttMapper> mqttMapper;
+        std::shared_ptr<MappingNamespaces> mappingNamespaces;
 
         CLI::Option* mappingFileOpt;
         CLI::Option* sessionStoreOpt;
-
-    private:
-        std::string mappFilename;
+        CLI::Option* mapperThreadsOpt;
+        CLI::Option* loopReportOpt;
     };
 
     class ConfigMqttBroker : public ConfigApplication {
@@ -100,8 +105,36 @@ namespace mqtt::lib {
         ConfigMqttBroker& setHtmlRoot(const std::string& htmlRoot);
         std::string getHtmlRoot();
 
+        ConfigMqttBroker& setEventLogLevel(int eventLogLevel);
+        int getEventLogLevel() const;
+
+        ConfigMqttBroker& setEventBatchWindow(std::size_t eventBatchWindow);
+        std::size_t getEventBatchWindow() const;
+
+        ConfigMqttBroker& setEventReceiverBudget(std::size_t eventReceiverBudget);
+        std::size_t getEventReceiverBudget() const;
+
+        ConfigMqttBroker& setEventReceiverOverflow(const std::string& eventReceiverOverflow);
+        std::string getEventReceiverOverflow() const;
+
+        ConfigMqttBroker& setEventReplaySize(std::size_t eventReplaySize);
+        std::size_t getEventReplaySize() const;
+
+        ConfigMqttBroker& setTrafficStatsCapacity(std::size_t trafficStatsCapacity);
+        std::size_t getTrafficStatsCapacity() const;
+
+        ConfigMqttBroker& setSysInterval(double sysInterval);
+        double getSysInterval() const;
+
     private:
         CLI::Option* htmlRootOpt;
+        CLI::Option* eventLogLevelOpt;
+        CLI::Option* eventBatchWindowOpt;
+        CLI::Option* eventReceiverBudgetOpt;
+        CLI::Option* eventReceiverOverflowOpt;
+        CLI::Option* eventReplaySizeOpt;
+        CLI::Option* trafficStatsCapacityOpt;
+        CLI::Option* sysIntervalOpt;
     };
 
     class ConfigMqttIntegrator : public ConfigApplication {
@@ -112,6 +145,41 @@ namespace mqtt::lib {
         ConfigMqttIntegrator(utils::SubCommand* parent);
 
         ~ConfigMqttIntegrator() override;
+
+        ConfigMqttIntegrator& setShards(std::size_t shards);
+        std::size_t getShards() const;
+
+        ConfigMqttIntegrator& setInflightWindow(std::size_t inflightWindow);
+        std::size_t getInflightWindow() const;
+
+        ConfigMqttIntegrator& setSendQueue(std::size_t sendQueue);
+        std::size_t getSendQueue() const;
+
+        ConfigMqttIntegrator& setOverflowPolicy(const std::string& overflowPolicy);
+        std::string getOverflowPolicy() const;
+
+        ConfigMqttIntegrator& setOutbox(const std::string& outbox);
+        std::string getOutbox() const;
+
+        ConfigMqttIntegrator& setOutboxSize(std::size_t outboxSize);
+        std::size_t getOutboxSize() const;
+
+        ConfigMqttIntegrator& setOutboxPolicy(const std::string& outboxPolicy);
+        std::string getOutboxPolicy() const;
+
+        ConfigMqttIntegrator& setOutboxDrainRate(std::size_t outboxDrainRate);
+        std::size_t getOutboxDrainRate() const;
+
+    private:
+        CLI::Option* mappingNamespacesOpt;
+        CLI::Option* shardsOpt;
+        CLI::Option* inflightWindowOpt;
+        CLI::Option* sendQueueOpt;
+        CLI::Option* overflowPolicyOpt;
+        CLI::Option* outboxOpt;
+        CLI::Option* outboxSizeOpt;
+        CLI::Option* outboxPolicyOpt;
+        CLI::Option* outboxDrainRateOpt;
     };
 
 } // namespace mqtt::lib
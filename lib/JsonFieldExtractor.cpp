@@ -0,0 +1,301 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "JsonFieldExtractor.h"
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <nlohmann/json.hpp>
+#include <regex>
+#include <utility>
+#include <vector>
+
+#endif
+
+namespace mqtt::lib {
+
+    class JsonFieldExtractor::SaxHandler {
+    public:
+        SaxHandler(const PathNode& root, std::size_t selectedCount, nlohmann::json& result)
+            : root(root)
+            , selectedCount(selectedCount)
+            , result(result) {
+        }
+
+        bool null() {
+            return value(nullptr);
+        }
+
+        bool boolean(bool val) {
+            return value(val);
+        }
+
+        bool number_integer(nlohmann::json::number_integer_t val) {
+            return value(val);
+        }
+
+        bool number_unsigned(nlohmann::json::number_unsigned_t val) {
+            return value(val);
+        }
+
+        bool number_float(nlohmann::json::number_float_t val, const nlohmann::json::string_t&) {
+            return value(val);
+        }
+
+        bool string(nlohmann::json::string_t& val) {
+            return value(std::move(val));
+        }
+
+        bool binary(nlohmann::json::binary_t& val) {
+            return value(std::move(val));
+        }
+
+        bool start_object(std::size_t) {
+            return startContainer(false);
+        }
+
+        bool key(nlohmann::json::string_t& val) {
+            if (!frames.empty() && frames.back().target != nullptr) {
+                pendingKey.assign(val); // val is the token buffer of the lexer, which keeps its capacity if not moved from
+            }
+
+            return true;
+        }
+
+        bool end_object() {
+            return endContainer();
+        }
+
+        bool start_array(std::size_t) {
+            return startContainer(true);
+        }
+
+        bool end_array() {
+            return endContainer();
+        }
+
+        template <typename ExceptionT>
+        bool parse_error(std::size_t, const std::string&, const ExceptionT& ex) {
+            throw ex;
+        }
+
+    private:
+        // target == nullptr: skipping an unreferenced container
+        // node == nullptr: materializing a referenced subtree
+        // otherwise: navigating along referenced paths
+        struct Frame {
+            const PathNode* node;
+            nlohmann::json* target;
+            std::size_t index;
+            bool counts;
+        };
+
+        // Returns the path node of the next element of a navigating frame and the slot its value is stored in
+        std::pair<const PathNode*, nlohmann::json*> nextChild(Frame& frame) {
+            std::pair<const PathNode*, nlohmann::json*> child{nullptr, nullptr};
+
+            if (frame.target->is_array()) {
+                const std::size_t index = frame.index++;
+                const auto childIt = frame.node->children.find(std::to_string(index));
+                if (childIt != frame.node->children.end()) {
+                    child = {&childIt->second, &(*frame.target)[index]};
+                }
+            } else {
+                const auto childIt = frame.node->children.find(pendingKey);
+                if (childIt != frame.node->children.end()) {
+                    child = {&childIt->second, &(*frame.target)[pendingKey]};
+                }
+            }
+
+            return child;
+        }
+
+        nlohmann::json& append(const Frame& frame, nlohmann::json&& val) {
+            if (frame.target->is_array()) {
+                frame.target->push_back(std::move(val));
+                return frame.target->back();
+            }
+
+            return (*frame.target)[pendingKey] = std::move(val);
+        }
+
+        // A json value is only built for values which are kept, values inside skipped containers cost nothing
+        template <typename ValueT>
+        bool value(ValueT&& val) {
+            bool proceed = true;
+
+            if (frames.empty()) {
+                result = std::forward<ValueT>(val);
+                proceed = false;
+            } else if (Frame& frame = frames.back(); frame.target != nullptr) {
+                if (frame.node == nullptr) {
+                    append(frame, nlohmann::json(std::forward<ValueT>(val)));
+                } else if (const auto [childNode, childSlot] = nextChild(frame); childNode != nullptr && childNode->selected) {
+                    *childSlot = std::forward<ValueT>(val);
+                    proceed = ++found < selectedCount;
+                }
+            }
+
+            return proceed;
+        }
+
+        static nlohmann::json container(bool isArray) {
+            return isArray ? nlohmann::json::array() : nlohmann::json::object();
+        }
+
+        bool startContainer(bool isArray) {
+            if (frames.empty()) {
+                result = container(isArray);
+                frames.push_back({&root, &result, 0, false});
+            } else if (Frame& frame = frames.back(); frame.target == nullptr) {
+                frames.push_back({nullptr, nullptr, 0, false});
+            } else if (frame.node == nullptr) {
+                nlohmann::json& child = append(frame, container(isArray));
+                frames.push_back({nullptr, &child, 0, false});
+            } else if (const auto [childNode, childSlot] = nextChild(frame); childNode != nullptr) {
+                *childSlot = container(isArray);
+                frames.push_back({childNode->selected ? nullptr : childNode, childSlot, 0, childNode->selected});
+            } else {
+                frames.push_back({nullptr, nullptr, 0, false});
+            }
+
+            return selectedCount > 0;
+        }
+
+        bool endContainer() {
+            const bool counts = frames.back().counts;
+            frames.pop_back();
+
+            return !counts || ++found < selectedCount;
+        }
+
+        const PathNode& root;
+        std::size_t selectedCount;
+        nlohmann::json& result;
+
+        std::vector<Frame> frames;
+        std::string pendingKey;
+        std::size_t found = 0;
+    };
+
+    void JsonFieldExtractor::addTemplate(const std::string& templateString) {
+        // Expressions, statements and line statements - the only places where "message" can be referenced
+        static const std::regex blockRegex(R"(\{\{[\s\S]*?\}\}|\{%[\s\S]*?%\}|^\s*##.*$)", std::regex::multiline);
+        static const std::regex stringRegex(R"("(?:[^"\\]|\\.)*")");
+        static const std::regex referenceRegex(R"((^|[^A-Za-z0-9_.])message((?:\.[A-Za-z0-9_]+)*))");
+        static const std::regex quotedPathRegex(R"regex(^"message((?:\.[A-Za-z0-9_]+)*)"$)regex");
+
+        for (std::sregex_iterator blockIt(templateString.begin(), templateString.end(), blockRegex); blockIt != std::sregex_iterator();
+             ++blockIt) {
+            const std::string block = blockIt->str();
+
+            // Paths given as string literals, e.g. exists("message.temp")
+            for (std::sregex_iterator stringIt(block.begin(), block.end(), stringRegex); stringIt != std::sregex_iterator(); ++stringIt) {
+                std::smatch quotedPath;
+                const std::string literal = stringIt->str();
+                if (std::regex_match(literal, quotedPath, quotedPathRegex)) {
+                    addPath(quotedPath[1]);
+                }
+            }
+
+            const std::string expression = std::regex_replace(block, stringRegex, "\"\"");
+            for (std::sregex_iterator referenceIt(expression.begin(), expression.end(), referenceRegex);
+                 referenceIt != std::sregex_iterator();
+                 ++referenceIt) {
+                addPath((*referenceIt)[2]);
+            }
+        }
+
+        selectedCount = countSelected(root);
+    }
+
+    bool JsonFieldExtractor::isSelective() const {
+        return !wholeDocument;
+    }
+
+    nlohmann::json JsonFieldExtractor::extract(const std::string& payload) const {
+        nlohmann::json result;
+
+        if (wholeDocument) {
+            result = nlohmann::json::parse(payload);
+        } else {
+            SaxHandler saxHandler(root, selectedCount, result);
+            nlohmann::json::sax_parse(payload, &saxHandler);
+        }
+
+        return result;
+    }
+
+    void JsonFieldExtractor::addPath(const std::string& path) {
+        if (path.empty()) {
+            wholeDocument = true;
+        } else {
+            PathNode* pathNode = &root;
+
+            std::string::size_type begin = 1; // skip leading '.'
+            while (!pathNode->selected && begin <= path.size()) {
+                std::string::size_type end = path.find('.', begin);
+                if (end == std::string::npos) {
+                    end = path.size();
+                }
+
+                pathNode = &pathNode->children[path.substr(begin, end - begin)];
+                begin = end + 1;
+            }
+
+            if (!pathNode->selected) {
+                pathNode->selected = true;
+                pathNode->children.clear();
+            }
+        }
+    }
+
+    std::size_t JsonFieldExtractor::countSelected(const PathNode& pathNode) {
+        std::size_t count = pathNode.selected ? 1 : 0;
+
+        for (const auto& [name, child] : pathNode.children) {
+            count += countSelected(child);
+        }
+
+        return count;
+    }
+
+} // namespace mqtt::lib
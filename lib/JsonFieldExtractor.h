@@ -0,0 +1,88 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTBROKER_LIB_JSONFIELDEXTRACTOR_H
+#define MQTTBROKER_LIB_JSONFIELDEXTRACTOR_H
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <nlohmann/json_fwd.hpp> // IWYU pragma: export
+#include <string>
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+namespace mqtt::lib {
+
+    // Collects the "message.*" paths referenced by the templates of a json subscription and parses incoming payloads with a SAX
+    // parser which only materializes those paths. Parsing stops as soon as all referenced paths have been found, thus payload
+    // validity is checked only up to that point. Templates referencing "message" as a whole disable the selective parse.
+    class JsonFieldExtractor {
+    public:
+        JsonFieldExtractor() = default;
+
+        void addTemplate(const std::string& templateString);
+
+        bool isSelective() const;
+
+        nlohmann::json extract(const std::string& payload) const; // can throw nlohmann::json::parse_error
+
+    private:
+        struct PathNode {
+            bool selected = false;
+            std::map<std::string, PathNode, std::less<>> children;
+        };
+
+        class SaxHandler;
+
+        void addPath(const std::string& path);
+        static std::size_t countSelected(const PathNode& pathNode);
+
+        PathNode root;
+        bool wholeDocument = false;
+        std::size_t selectedCount = 0;
+    };
+
+} // namespace mqtt::lib
+
+#endif // MQTTBROKER_LIB_JSONFIELDEXTRACTOR_H
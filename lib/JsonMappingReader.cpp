@@ -43,7 +43,7 @@
 
 #include "JsonMappingReader.h"
 
-#include "ConfigApplication.h"
+#include "MappingNamespace.h"
 #include "MqttMapper.h"
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -422,24 +422,24 @@ namespace mqtt::lib {
             }
         }
 
-        ActiveState readActiveState(const ConfigApplication* configApplication) {
-            return ActiveState{configApplication->getMqttMapper()->getMapping(), configApplication->getMqttMapper()->getRevision()};
+        ActiveState readActiveState(const MappingNamespace* mappingNamespace) {
+            return ActiveState{mappingNamespace->getMqttMapper()->getMapping(), mappingNamespace->getMqttMapper()->getRevision()};
         }
 
         JsonMappingReader::ApplyResult
-        applyMappingAndPersist(ConfigApplication* configApplication, const nlohmann::json& mapping, const std::string& draftId) {
-            const bool mustReconnect = configApplication->getMqttMapper()->setMapping(mapping);
-            const bool mappingPersisted = configApplication->persistMapping();
-            return JsonMappingReader::ApplyResult{configApplication->getMqttMapper()->getRevision(),
+        applyMappingAndPersist(MappingNamespace* mappingNamespace, const nlohmann::json& mapping, const std::string& draftId) {
+            const bool mustReconnect = mappingNamespace->setMapping(mapping);
+            const bool mappingPersisted = mappingNamespace->persistMapping();
+            return JsonMappingReader::ApplyResult{mappingNamespace->getMqttMapper()->getRevision(),
                                                   draftId,
                                                   mappingPersisted,
                                                   mustReconnect};
         }
 
         template <typename Operation>
-        auto withActiveStateLock(const std::string& adminStorageRoot, ConfigApplication* configApplication, Operation&& operation) {
+        auto withActiveStateLock(const std::string& adminStorageRoot, MappingNamespace* mappingNamespace, Operation&& operation) {
             ExclusiveFileLock lock(adminStorageRoot);
-            const ActiveState activeState = readActiveState(configApplication);
+            const ActiveState activeState = readActiveState(mappingNamespace);
             return std::forward<Operation>(operation)(activeState);
         }
 
@@ -506,9 +506,9 @@ namespace mqtt::lib {
     } // namespace
 
     nlohmann::json JsonMappingReader::createDraftFromActive(const std::string& adminStorageRoot,
-                                                            ConfigApplication* configApplication,
+                                                            MappingNamespace* mappingNamespace,
                                                             const std::string& draftId) {
-        return withActiveStateLock(adminStorageRoot, configApplication, [&](const ActiveState& activeState) {
+        return withActiveStateLock(adminStorageRoot, mappingNamespace, [&](const ActiveState& activeState) {
             const std::string resolvedDraftId =
                 createDraftFromMappingNoLock(adminStorageRoot, activeState.mapping, activeState.revision, draftId);
             return readDraftEnvelopeNoLock(adminStorageRoot, resolvedDraftId);
@@ -577,11 +577,11 @@ namespace mqtt::lib {
     }
 
     nlohmann::json JsonMappingReader::replaceDraftWithAutoCreate(const std::string& adminStorageRoot,
-                                                                 ConfigApplication* configApplication,
+                                                                 MappingNamespace* mappingNamespace,
                                                                  const std::string& draftId,
                                                                  const nlohmann::json& mapping,
                                                                  std::optional<int64_t> expectedDraftRevision) {
-        return withActiveStateLock(adminStorageRoot, configApplication, [&](const ActiveState& activeState) {
+        return withActiveStateLock(adminStorageRoot, mappingNamespace, [&](const ActiveState& activeState) {
             return mutateDraftWithAutoCreateNoLock(
                 adminStorageRoot,
                 activeState.mapping,
@@ -595,11 +595,11 @@ namespace mqtt::lib {
     }
 
     nlohmann::json JsonMappingReader::patchDraftWithAutoCreate(const std::string& adminStorageRoot,
-                                                               ConfigApplication* configApplication,
+                                                               MappingNamespace* mappingNamespace,
                                                                const std::string& draftId,
                                                                const nlohmann::json& patchOps,
                                                                std::optional<int64_t> expectedDraftRevision) {
-        return withActiveStateLock(adminStorageRoot, configApplication, [&](const ActiveState& activeState) {
+        return withActiveStateLock(adminStorageRoot, mappingNamespace, [&](const ActiveState& activeState) {
             return mutateDraftWithAutoCreateNoLock(
                 adminStorageRoot,
                 activeState.mapping,
@@ -683,23 +683,23 @@ namespace mqtt::lib {
     }
 
     JsonMappingReader::ApplyResult JsonMappingReader::deployAndApplyDraft(const std::string& adminStorageRoot,
-                                                                          ConfigApplication* configApplication,
+                                                                          MappingNamespace* mappingNamespace,
                                                                           const std::string& draftId,
                                                                           const std::optional<std::uint64_t>& expectedActiveRevision) {
-        return withActiveStateLock(adminStorageRoot, configApplication, [&](const ActiveState& activeState) {
+        return withActiveStateLock(adminStorageRoot, mappingNamespace, [&](const ActiveState& activeState) {
             nlohmann::json newMapping = buildDeployMappingNoLock(adminStorageRoot, draftId, activeState.revision, expectedActiveRevision);
             saveCurrentAsVersionNoLock(adminStorageRoot, activeState.mapping);
             removeDraftNoLock(adminStorageRoot, draftId);
-            return applyMappingAndPersist(configApplication, newMapping, draftId);
+            return applyMappingAndPersist(mappingNamespace, newMapping, draftId);
         });
     }
 
     JsonMappingReader::ApplyResult JsonMappingReader::rollbackAndApplyVersion(
         const std::string& adminStorageRoot,
-        ConfigApplication* configApplication,
+        MappingNamespace* mappingNamespace,
         const std::string& snapshotId,
         const std::optional<std::uint64_t>& expectedActiveRevision) {
-        return withActiveStateLock(adminStorageRoot, configApplication, [&](const ActiveState& activeState) {
+        return withActiveStateLock(adminStorageRoot, mappingNamespace, [&](const ActiveState& activeState) {
             const fs::path backupPath = getVersionDir(adminStorageRoot) / (snapshotId + ".json");
             if (!fs::exists(backupPath)) {
                 throw EntityNotFoundError("Snapshot not found: " + snapshotId);
@@ -715,7 +715,7 @@ namespace mqtt::lib {
             setDeployMetadata(rollbackMapping, activeState.revision + 1);
             rollbackMapping["meta"]["rolled_back_from"] = snapshotId;
 
-            return applyMappingAndPersist(configApplication, rollbackMapping, "");
+            return applyMappingAndPersist(mappingNamespace, rollbackMapping, "");
         });
     }
 
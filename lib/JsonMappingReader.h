@@ -57,7 +57,7 @@
 
 namespace mqtt::lib {
 
-    class ConfigApplication;
+    class MappingNamespace;
 
     class OCCConflictError : public std::runtime_error {
     public:
@@ -86,7 +86,7 @@ namespace mqtt::lib {
 
         // Admin / Live Reload Support
         static nlohmann::json createDraftFromActive(const std::string& adminStorageRoot,
-                                ConfigApplication* configApplication,
+                                MappingNamespace* mappingNamespace,
                                 const std::string& draftId = "");
         static std::vector<nlohmann::json> listDrafts(const std::string& adminStorageRoot);
         static nlohmann::json readDraft(const std::string& adminStorageRoot, const std::string& draftId);
@@ -100,12 +100,12 @@ namespace mqtt::lib {
                                          const nlohmann::json& patchOps,
                                          std::optional<int64_t> expectedDraftRevision = std::nullopt);
         static nlohmann::json replaceDraftWithAutoCreate(const std::string& adminStorageRoot,
-                                 ConfigApplication* configApplication,
+                                 MappingNamespace* mappingNamespace,
                                  const std::string& draftId,
                                  const nlohmann::json& mapping,
                                  std::optional<int64_t> expectedDraftRevision = std::nullopt);
         static nlohmann::json patchDraftWithAutoCreate(const std::string& adminStorageRoot,
-                                   ConfigApplication* configApplication,
+                                   MappingNamespace* mappingNamespace,
                                    const std::string& draftId,
                                    const nlohmann::json& patchOps,
                                    std::optional<int64_t> expectedDraftRevision = std::nullopt);
@@ -123,12 +123,12 @@ namespace mqtt::lib {
         static std::vector<VersionEntry> getHistory(const std::string& adminStorageRoot);
 
         static ApplyResult deployAndApplyDraft(const std::string& adminStorageRoot,
-                               ConfigApplication* configApplication,
+                               MappingNamespace* mappingNamespace,
                                const std::string& draftId,
                                const std::optional<std::uint64_t>& expectedActiveRevision);
 
         static ApplyResult rollbackAndApplyVersion(const std::string& adminStorageRoot,
-                               ConfigApplication* configApplication,
+                               MappingNamespace* mappingNamespace,
                                const std::string& snapshotId,
                                const std::optional<std::uint64_t>& expectedActiveRevision);
     };
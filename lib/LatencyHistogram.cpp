@@ -0,0 +1,144 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "LatencyHistogram.h"
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+#endif
+
+namespace mqtt::lib {
+
+    void LatencyHistogram::record(std::uint64_t nanoseconds) {
+        buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+        std::uint64_t currentMax = max.load(std::memory_order_relaxed);
+        while (nanoseconds > currentMax && !max.compare_exchange_weak(currentMax, nanoseconds, std::memory_order_relaxed)) {
+        }
+    }
+
+    void LatencyHistogram::reset() {
+        for (std::atomic<std::uint64_t>& bucket : buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+
+        count.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+    nlohmann::json LatencyHistogram::toJson() const {
+        const std::uint64_t total = count.load(std::memory_order_relaxed);
+
+        return {{"count", total},
+                {"mean_ns", total > 0 ? sum.load(std::memory_order_relaxed) / total : 0},
+                {"p50_ns", percentile(0.5, total)},
+                {"p90_ns", percentile(0.9, total)},
+                {"p99_ns", percentile(0.99, total)},
+                {"p999_ns", percentile(0.999, total)},
+                {"max_ns", max.load(std::memory_order_relaxed)}};
+    }
+
+    std::uint64_t LatencyHistogram::getCount() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t LatencyHistogram::getSum() const {
+        return sum.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t LatencyHistogram::getQuantile(double quantile) const {
+        return percentile(quantile, count.load(std::memory_order_relaxed));
+    }
+
+    std::size_t LatencyHistogram::bucketIndex(std::uint64_t value) {
+        std::size_t index = static_cast<std::size_t>(value);
+
+        if (value >= SUB_BUCKETS) {
+            const unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS;
+
+            index = ((shift + 1) << SUB_BUCKET_BITS) + ((value >> shift) & (SUB_BUCKETS - 1));
+        }
+
+        return index;
+    }
+
+    std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t index) {
+        std::uint64_t upperBound = index;
+
+        if (index >= SUB_BUCKETS) {
+            const std::size_t shift = (index >> SUB_BUCKET_BITS) - 1;
+
+            upperBound = ((SUB_BUCKETS + (index & (SUB_BUCKETS - 1))) << shift) + ((std::uint64_t{1} << shift) - 1);
+        }
+
+        return upperBound;
+    }
+
+    std::uint64_t LatencyHistogram::percentile(double quantile, std::uint64_t total) const {
+        std::uint64_t value = 0;
+
+        if (total > 0) {
+            const std::uint64_t rank =
+                std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(quantile * static_cast<double>(total))));
+
+            std::uint64_t seen = 0;
+            for (std::size_t index = 0; index < buckets.size(); index++) {
+                seen += buckets[index].load(std::memory_order_relaxed);
+
+                if (seen >= rank) {
+                    value = bucketUpperBound(index);
+                    break;
+                }
+            }
+        }
+
+        return value;
+    }
+
+} // namespace mqtt::lib
@@ -0,0 +1,87 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTBROKER_LIB_LATENCYHISTOGRAM_H
+#define MQTTBROKER_LIB_LATENCYHISTOGRAM_H
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <nlohmann/json_fwd.hpp> // IWYU pragma: export
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+namespace mqtt::lib {
+
+    // Log-linear histogram in the spirit of HdrHistogram: each power of two is split into 8 linear sub-buckets, bounding the
+    // relative error of reported percentiles to 12.5%.
+    class LatencyHistogram {
+    public:
+        void record(std::uint64_t nanoseconds);
+        void reset();
+
+        nlohmann::json toJson() const;
+
+        std::uint64_t getCount() const;
+        std::uint64_t getSum() const; // in ns
+        std::uint64_t getQuantile(double quantile) const;
+
+    private:
+        static constexpr unsigned SUB_BUCKET_BITS = 3;
+        static constexpr std::size_t SUB_BUCKETS = std::size_t{1} << SUB_BUCKET_BITS;
+
+        static std::size_t bucketIndex(std::uint64_t value);
+        static std::uint64_t bucketUpperBound(std::size_t index);
+
+        std::uint64_t percentile(double quantile, std::uint64_t total) const;
+
+        std::array<std::atomic<std::uint64_t>, (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS> buckets{};
+        std::atomic<std::uint64_t> count = 0;
+        std::atomic<std::uint64_t> sum = 0;
+        std::atomic<std::uint64_t> max = 0;
+    };
+
+} // namespace mqtt::lib
+
+#endif // MQTTBROKER_LIB_LATENCYHISTOGRAM_H
@@ -0,0 +1,180 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "LoopMonitor.h"
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <cstdint>
+#include <log/Logger.h>
+#include <nlohmann/json.hpp>
+
+#endif
+
+namespace mqtt::lib {
+
+    namespace {
+
+        constexpr std::chrono::milliseconds PROBE_INTERVAL{100};
+        constexpr double REPORT_INTERVAL = 10;
+
+        constexpr std::chrono::milliseconds STALL_THRESHOLD{500};
+
+        std::uint64_t toNanoseconds(std::chrono::steady_clock::duration duration) {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        }
+
+    } // namespace
+
+    thread_local LoopMonitor::Timing* LoopMonitor::Timing::innermost = nullptr;
+
+    LoopMonitor::Timing::Timing(LatencyHistogram& section)
+        : section(&section)
+        , start(std::chrono::steady_clock::now())
+        , outer(innermost) {
+        for (const Timing* timing = outer; timing != nullptr && this->section != nullptr; timing = timing->outer) {
+            if (timing->section == &section) {
+                this->section = nullptr;
+            }
+        }
+
+        innermost = this;
+    }
+
+    LoopMonitor::Timing::~Timing() {
+        innermost = outer;
+
+        if (section != nullptr) {
+            section->record(toNanoseconds(std::chrono::steady_clock::now() - start));
+        }
+    }
+
+    LoopMonitor& LoopMonitor::instance() {
+        static LoopMonitor loopMonitor;
+
+        return loopMonitor;
+    }
+
+    void LoopMonitor::start(const std::string& application, bool report) {
+        this->application = application;
+
+        if (!started) {
+            started = true;
+
+            armProbe();
+
+            if (report) {
+                reportTimer = core::timer::Timer::intervalTimer(
+                    [this]() {
+                        this->report();
+                    },
+                    REPORT_INTERVAL);
+            }
+        }
+    }
+
+    void LoopMonitor::armProbe() {
+        probeDue = std::chrono::steady_clock::now() + PROBE_INTERVAL;
+
+        probeTimer = core::timer::Timer::singleshotTimer(
+            [this]() {
+                const std::chrono::steady_clock::duration late = std::chrono::steady_clock::now() - probeDue;
+
+                lag.record(late > std::chrono::steady_clock::duration::zero() ? toNanoseconds(late) : 0);
+
+                if (late >= STALL_THRESHOLD) {
+                    VLOG(1) << "Event loop stalled for " << std::chrono::duration_cast<std::chrono::milliseconds>(late).count() << " ms";
+                }
+
+                armProbe();
+            },
+            std::chrono::duration<double>(PROBE_INTERVAL).count());
+    }
+
+    LatencyHistogram& LoopMonitor::getSection(const std::string& name) {
+        std::unique_ptr<LatencyHistogram>& section = sections[name];
+
+        if (section == nullptr) {
+            section = std::make_unique<LatencyHistogram>();
+        }
+
+        return *section;
+    }
+
+    void LoopMonitor::addReporter(const void* owner, const Reporter& reporter) {
+        removeReporter(owner);
+
+        reporters.emplace_back(owner, reporter);
+    }
+
+    void LoopMonitor::removeReporter(const void* owner) {
+        reporters.remove_if([owner](const std::pair<const void*, Reporter>& reporter) {
+            return reporter.first == owner;
+        });
+    }
+
+    void LoopMonitor::report() const {
+        if (!reporters.empty()) {
+            reporters.front().second("$SYS/mqttsuite/" + application + "/loop", toJson().dump());
+        }
+    }
+
+    void LoopMonitor::reset() {
+        lag.reset();
+
+        for (const auto& [name, section] : sections) {
+            section->reset();
+        }
+    }
+
+    nlohmann::json LoopMonitor::toJson() const {
+        nlohmann::json sectionsJson = nlohmann::json::object();
+        for (const auto& [name, section] : sections) {
+            sectionsJson[name] = section->toJson();
+        }
+
+        return {{"application", application},
+                {"probe_interval_ms", PROBE_INTERVAL.count()},
+                {"lag", lag.toJson()},
+                {"sections", sectionsJson}};
+    }
+
+} // namespace mqtt::lib
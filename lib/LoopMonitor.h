@@ -0,0 +1,127 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTBROKER_LIB_LOOPMONITOR_H
+#define MQTTBROKER_LIB_LOOPMONITOR_H
+
+#include "LatencyHistogram.h"
+
+#include <core/timer/Timer.h>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <nlohmann/json_fwd.hpp> // IWYU pragma: export
+#include <string>
+#include <utility>
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+namespace mqtt::lib {
+
+    // Watches the responsiveness of the event loop. A probe timer measures how late it fires (the time the loop was busy with
+    // something else), and Timing scopes account the wall time spent in named sections such as "onPublish" or "admin". The
+    // histograms are served by the admin APIs and periodically published as JSON to $SYS/mqttsuite/<application>/loop through
+    // the first registered reporter.
+    class LoopMonitor {
+    public:
+        using Reporter = std::function<void(const std::string& topic, const std::string& message)>;
+
+        // Only the outermost Timing of a section records, so recursive sections (e.g. onPublish feeding mapped publishes back
+        // into itself) count one sample of their whole wall time.
+        class Timing {
+        public:
+            explicit Timing(LatencyHistogram& section);
+            Timing(const Timing&) = delete;
+            Timing& operator=(const Timing&) = delete;
+
+            ~Timing();
+
+        private:
+            LatencyHistogram* section; // nullptr if nested in a Timing of the same section
+            std::chrono::steady_clock::time_point start;
+
+            Timing* outer;
+            static thread_local Timing* innermost;
+        };
+
+        LoopMonitor(const LoopMonitor&) = delete;
+        LoopMonitor& operator=(const LoopMonitor&) = delete;
+
+        static LoopMonitor& instance();
+
+        // On the event loop, after SNodeC::init(). Without report the histograms are only served by the admin APIs.
+        void start(const std::string& application, bool report = true);
+
+        LatencyHistogram& getSection(const std::string& name); // references stay valid
+
+        void addReporter(const void* owner, const Reporter& reporter);
+        void removeReporter(const void* owner);
+
+        void reset();
+        nlohmann::json toJson() const;
+
+    private:
+        LoopMonitor() = default;
+
+        void armProbe();
+        void report() const;
+
+        std::string application;
+
+        LatencyHistogram lag;
+        std::map<std::string, std::unique_ptr<LatencyHistogram>> sections;
+
+        std::list<std::pair<const void*, Reporter>> reporters;
+
+        std::chrono::steady_clock::time_point probeDue;
+        core::timer::Timer probeTimer;
+        core::timer::Timer reportTimer;
+        bool started = false;
+    };
+
+} // namespace mqtt::lib
+
+#endif // MQTTBROKER_LIB_LOOPMONITOR_H
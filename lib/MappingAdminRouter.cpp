@@ -43,6 +43,8 @@
 
 #include "ConfigApplication.h"
 #include "JsonMappingReader.h"
+#include "LoopMonitor.h"
+#include "MappingNamespace.h"
 #include "MqttMapper.h"
 
 #include <express/middleware/BasicAuthentication.h>
@@ -55,6 +57,7 @@
 #include <exception>
 #include <filesystem>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <utility>
 
@@ -303,7 +306,7 @@ namespace {
     template <typename RequestPtr, typename ResponsePtr>
     void handleDeployRequest(const RequestPtr& req,
                              const ResponsePtr& res,
-                             mqtt::lib::ConfigApplication* configApplication,
+                             mqtt::lib::MappingNamespace* mappingNamespace,
                              const std::string& adminStorageRoot,
                              const mqtt::lib::admin::ReloadCallback& onDeploy) {
         try {
@@ -330,9 +333,13 @@ namespace {
         }
     }
 
-    std::string buildAdminStorageRoot(const mqtt::lib::ConfigApplication* configApplication) {
+    std::string buildAdminStorageRoot(const mqtt::lib::ConfigApplication* configApplication,
+                                      const mqtt::lib::MappingNamespace* mappingNamespace) {
         namespace fs = std::filesystem;
-        const fs::path adminRoot = fs::temp_directory_path() / "mqttsuite" / "admin" / configApplication->getName();
+        fs::path adminRoot = fs::temp_directory_path() / "mqttsuite" / "admin" / configApplication->getName();
+        if (mappingNamespace != configApplication->getDefaultMappingNamespace().get()) {
+            adminRoot /= fs::path("namespaces") / mappingNamespace->getName();
+        }
         fs::create_directories(adminRoot);
         return adminRoot.string();
     }
@@ -341,157 +348,241 @@ namespace {
 
 namespace mqtt::lib::admin {
 
-    express::Router makeMappingAdminRouter(ConfigApplication* configApplication, const AdminOptions& opt, ReloadCallback onDeploy) {
-        express::Router api;
-        const std::string adminStorageRoot = buildAdminStorageRoot(configApplication);
+    namespace {
+
+        // Routes operating on the active mapping, drafts, history and metrics of one namespace
+        void addNamespaceRoutes(express::Router& api,
+                                MappingNamespace* mappingNamespace,
+                                const std::string& adminStorageRoot,
+                                const ReloadCallback& onDeploy) {
+            // GET /config (active mapping)
+            api.get("/config", [mappingNamespace] APPLICATION(req, res) {
+                try {
+                    const nlohmann::json active = mappingNamespace->getMqttMapper()->getMapping();
+                    const std::uint64_t revision = mappingNamespace->getMqttMapper()->getRevision();
+                    setRevisionHeaders(res, revision);
+
+                    res->status(200).json(active);
+                } catch (const std::exception& e) {
+                    res->status(500).json({{"error", "Failed to load configuration"}, {"details", e.what()}});
+                }
+            });
 
-        api.use(express::middleware::JsonMiddleware());
-        api.use(express::middleware::BasicAuthentication(opt.user, opt.pass, opt.realm));
+            // POST /drafts/create
+            api.post("/drafts/create", [mappingNamespace, adminStorageRoot] APPLICATION(req, res) {
+                try {
+                    nlohmann::json body = parseJsonBody(req, true);
+                    const nlohmann::json draft = JsonMappingReader::createDraftFromActive(
+                        adminStorageRoot,
+                        mappingNamespace,
+                        body.contains("draft_id") ? body.at("draft_id").get<std::string>() : "");
+                    res->status(201).json(draft);
+                } catch (const OCCConflictError& e) {
+                    res->status(409).json({{"error", "Draft already exists"}, {"details", e.what()}});
+                } catch (const std::exception& e) {
+                    res->status(400).json({{"error", "Draft creation failed"}, {"details", e.what()}});
+                }
+            });
 
-        // GET /schema
-        api.get("/schema", [] APPLICATION(req, res) {
-            res->status(200).send(MqttMapper::getSchema());
-        });
+            // GET /drafts/list
+            api.get("/drafts/list", [adminStorageRoot] APPLICATION(req, res) {
+                try {
+                    res->status(200).json(JsonMappingReader::listDrafts(adminStorageRoot));
+                } catch (const std::exception& e) {
+                    res->status(500).json({{"error", "Failed to list drafts"}, {"details", e.what()}});
+                }
+            });
 
-        // GET /config (active mapping)
-        api.get("/config", [configApplication] APPLICATION(req, res) {
-            try {
-                const nlohmann::json active = configApplication->getMqttMapper()->getMapping();
-                const std::uint64_t revision = configApplication->getMqttMapper()->getRevision();
-                setRevisionHeaders(res, revision);
+            // POST /drafts/get
+            api.post("/drafts/get", [adminStorageRoot] APPLICATION(req, res) {
+                try {
+                    const nlohmann::json body = parseJsonBody(req, true);
+                    const std::string draftId = resolveDraftId(req, &body);
+                    res->status(200).json(JsonMappingReader::readDraft(adminStorageRoot, draftId));
+                } catch (const EntityNotFoundError& e) {
+                    res->status(404).json({{"error", "Draft not found"}, {"details", e.what()}});
+                } catch (const std::exception& e) {
+                    res->status(400).json({{"error", "Failed to load draft"}, {"details", e.what()}});
+                }
+            });
 
-                res->status(200).json(active);
-            } catch (const std::exception& e) {
-                res->status(500).json({{"error", "Failed to load configuration"}, {"details", e.what()}});
-            }
-        });
+            // PATCH /drafts/patch
+            api.patch("/drafts/patch", [adminStorageRoot] APPLICATION(req, res) {
+                handleDraftMutationRequest(
+                    req,
+                    res,
+                    adminStorageRoot,
+                    "PATCH /drafts/patch",
+                    "Draft patch failed",
+                    [](const nlohmann::json& body) -> const nlohmann::json& {
+                        return body.at("patch");
+                    },
+                    [adminStorageRoot](const std::string& draftId,
+                                       const nlohmann::json& patchOps,
+                                       std::optional<int64_t> expectedDraftRevision) {
+                        return JsonMappingReader::patchDraft(adminStorageRoot, draftId, patchOps, expectedDraftRevision);
+                    });
+            });
 
-        // POST /drafts/create
-        api.post("/drafts/create", [configApplication, adminStorageRoot] APPLICATION(req, res) {
-            try {
-                nlohmann::json body = parseJsonBody(req, true);
-                const nlohmann::json draft = JsonMappingReader::createDraftFromActive(
+            // POST /drafts/replace
+            api.post("/drafts/replace", [adminStorageRoot] APPLICATION(req, res) {
+                handleDraftMutationRequest(
+                    req,
+                    res,
                     adminStorageRoot,
-                    configApplication,
-                    body.contains("draft_id") ? body.at("draft_id").get<std::string>() : "");
-                res->status(201).json(draft);
-            } catch (const OCCConflictError& e) {
-                res->status(409).json({{"error", "Draft already exists"}, {"details", e.what()}});
-            } catch (const std::exception& e) {
-                res->status(400).json({{"error", "Draft creation failed"}, {"details", e.what()}});
-            }
-        });
+                    "POST /drafts/replace",
+                    "Draft replacement failed",
+                    [](const nlohmann::json& body) -> const nlohmann::json& {
+                        return body.at("mapping");
+                    },
+                    [adminStorageRoot](const std::string& draftId,
+                                       const nlohmann::json& mapping,
+                                       std::optional<int64_t> expectedDraftRevision) {
+                        return JsonMappingReader::replaceDraft(adminStorageRoot, draftId, mapping, expectedDraftRevision);
+                    });
+            });
 
-        // GET /drafts/list
-        api.get("/drafts/list", [adminStorageRoot] APPLICATION(req, res) {
-            try {
-                res->status(200).json(JsonMappingReader::listDrafts(adminStorageRoot));
-            } catch (const std::exception& e) {
-                res->status(500).json({{"error", "Failed to list drafts"}, {"details", e.what()}});
-            }
-        });
+            // POST /drafts/validate
+            api.post("/drafts/validate", [adminStorageRoot] APPLICATION(req, res) {
+                handleDraftValidationRequest(res, adminStorageRoot, "Draft not found", [&]() {
+                    const nlohmann::json body = parseJsonBody(req, true);
+                    return resolveDraftId(req, &body);
+                });
+            });
 
-        // POST /drafts/get
-        api.post("/drafts/get", [adminStorageRoot] APPLICATION(req, res) {
-            try {
-                const nlohmann::json body = parseJsonBody(req, true);
-                const std::string draftId = resolveDraftId(req, &body);
-                res->status(200).json(JsonMappingReader::readDraft(adminStorageRoot, draftId));
-            } catch (const EntityNotFoundError& e) {
-                res->status(404).json({{"error", "Draft not found"}, {"details", e.what()}});
-            } catch (const std::exception& e) {
-                res->status(400).json({{"error", "Failed to load draft"}, {"details", e.what()}});
-            }
-        });
+            // POST /drafts/deploy
+            api.post("/drafts/deploy", [mappingNamespace, adminStorageRoot, onDeploy] APPLICATION(req, res) {
+                handleDeployRequest(req, res, mappingNamespace, adminStorageRoot, onDeploy);
+            });
 
-        // PATCH /drafts/patch
-        api.patch("/drafts/patch", [adminStorageRoot] APPLICATION(req, res) {
-            handleDraftMutationRequest(
-                req,
-                res,
-                adminStorageRoot,
-                "PATCH /drafts/patch",
-                "Draft patch failed",
-                [](const nlohmann::json& body) -> const nlohmann::json& {
-                    return body.at("patch");
-                },
-                [adminStorageRoot](const std::string& draftId,
-                                   const nlohmann::json& patchOps,
-                                   std::optional<int64_t> expectedDraftRevision) {
-                    return JsonMappingReader::patchDraft(adminStorageRoot, draftId, patchOps, expectedDraftRevision);
-                });
-        });
+            // POST /drafts/delete
+            api.post("/drafts/delete", [adminStorageRoot] APPLICATION(req, res) {
+                try {
+                    const nlohmann::json body = parseJsonBody(req, true);
+                    const std::string draftId = resolveDraftId(req, &body);
+                    JsonMappingReader::discardDraft(adminStorageRoot, draftId);
+                    res->status(200).json({{"status", "deleted"}, {"draft_id", draftId}});
+                } catch (const std::exception& e) {
+                    res->status(400).json({{"error", "Draft delete failed"}, {"details", e.what()}});
+                }
+            });
 
-        // POST /drafts/replace
-        api.post("/drafts/replace", [adminStorageRoot] APPLICATION(req, res) {
-            handleDraftMutationRequest(
-                req,
-                res,
-                adminStorageRoot,
-                "POST /drafts/replace",
-                "Draft replacement failed",
-                [](const nlohmann::json& body) -> const nlohmann::json& {
-                    return body.at("mapping");
-                },
-                [adminStorageRoot](const std::string& draftId,
-                                   const nlohmann::json& mapping,
-                                   std::optional<int64_t> expectedDraftRevision) {
-                    return JsonMappingReader::replaceDraft(adminStorageRoot, draftId, mapping, expectedDraftRevision);
+            // PATCH /config (legacy default draft)
+            api.patch("/config", [mappingNamespace, adminStorageRoot] APPLICATION(req, res) {
+                handleLegacyDefaultDraftMutation(
+                    req,
+                    res,
+                    "patched",
+                    "Patch application failed",
+                    [adminStorageRoot, mappingNamespace](const nlohmann::json& payload, const std::string& draftId) {
+                        JsonMappingReader::patchDraftWithAutoCreate(adminStorageRoot, mappingNamespace, draftId, payload, std::nullopt);
+                    });
+            });
+
+            // POST /config (legacy replace full draft)
+            api.post("/config", [mappingNamespace, adminStorageRoot] APPLICATION(req, res) {
+                handleLegacyDefaultDraftMutation(
+                    req,
+                    res,
+                    "replaced",
+                    "Config replacement failed",
+                    [adminStorageRoot, mappingNamespace](const nlohmann::json& payload, const std::string& draftId) {
+                        JsonMappingReader::replaceDraftWithAutoCreate(adminStorageRoot, mappingNamespace, draftId, payload, std::nullopt);
+                    });
+            });
+
+            // POST /config/deploy (legacy wrapper)
+            api.post("/config/deploy", [mappingNamespace, adminStorageRoot, onDeploy] APPLICATION(req, res) {
+                handleDeployRequest(req, res, mappingNamespace, adminStorageRoot, onDeploy);
+            });
+
+            // GET /config/validateDraft (legacy wrapper)
+            api.get("/config/validateDraft", [adminStorageRoot] APPLICATION(req, res) {
+                handleDraftValidationRequest(res, adminStorageRoot, "No draft configuration available", []() {
+                    return std::string(DEFAULT_DRAFT_ID);
                 });
-        });
+            });
 
-        // POST /drafts/validate
-        api.post("/drafts/validate", [adminStorageRoot] APPLICATION(req, res) {
-            handleDraftValidationRequest(res, adminStorageRoot, "Draft not found", [&]() {
-                const nlohmann::json body = parseJsonBody(req, true);
-                return resolveDraftId(req, &body);
+            // POST /config/rollback
+            api.post("/config/rollback", [mappingNamespace, adminStorageRoot, onDeploy] APPLICATION(req, res) {
+                try {
+                    auto jsonBody = parseJsonBody(req);
+
+                    const std::optional<std::string> snapshotId = resolveSnapshotId(jsonBody);
+                    if (!snapshotId) {
+                        res->status(400).json({{"error", "Missing snapshot_id"}, {"details", "Provide snapshot_id"}});
+                        return;
+                    }
+                    const std::optional<std::uint64_t> expectedRevision = resolveExpectedRevision(req, &jsonBody);
+
+                    const mqtt::lib::JsonMappingReader::ApplyResult applyResult =
+                        mqtt::lib::JsonMappingReader::rollbackAndApplyVersion(
+                            adminStorageRoot, mappingNamespace, *snapshotId, expectedRevision);
+
+                    const MappingApplyResult responseResult = toMappingApplyResult(applyResult, onDeploy);
+                    setRevisionHeaders(res, responseResult.revision);
+                    res->status(200).json(makeDeployAckResponse(responseResult));
+                } catch (const nlohmann::json::parse_error& e) {
+                    res->status(400).json({{"error", "Invalid JSON body"}, {"details", e.what()}});
+                } catch (const OCCConflictError& e) {
+                    respondRevisionConflict(res, e.what(), [&]() -> std::optional<std::uint64_t> {
+                        return mappingNamespace->getMqttMapper()->getRevision();
+                    });
+                } catch (const EntityNotFoundError& e) {
+                    res->status(404).json({{"error", "Snapshot not found"}, {"details", e.what()}});
+                } catch (const std::exception& e) {
+                    res->status(500).json({{"error", "Rollback failed"}, {"details", e.what()}});
+                }
             });
-        });
 
-        // POST /drafts/deploy
-        api.post("/drafts/deploy", [configApplication, adminStorageRoot, onDeploy] APPLICATION(req, res) {
-            handleDeployRequest(req, res, configApplication, adminStorageRoot, onDeploy);
-        });
+            // GET /config/history
+            api.get("/config/history", [adminStorageRoot] APPLICATION(req, res) {
+                try {
+                    auto history = JsonMappingReader::getHistory(adminStorageRoot);
+                    nlohmann::json list = nlohmann::json::array();
+                    for (const auto& h : history) {
+                        list.push_back({{"snapshot_id", h.snapshotId}, {"comment", h.comment}, {"date", h.date}});
+                    }
+                    res->status(200).json(list);
+                } catch ([[maybe_unused]] const std::exception& e) {
+                    res->status(500).json({{"error", "Failed to fetch history"}});
+                }
+            });
 
-        // POST /drafts/delete
-        api.post("/drafts/delete", [adminStorageRoot] APPLICATION(req, res) {
-            try {
-                const nlohmann::json body = parseJsonBody(req, true);
-                const std::string draftId = resolveDraftId(req, &body);
-                JsonMappingReader::discardDraft(adminStorageRoot, draftId);
-                res->status(200).json({{"status", "deleted"}, {"draft_id", draftId}});
-            } catch (const std::exception& e) {
-                res->status(400).json({{"error", "Draft delete failed"}, {"details", e.what()}});
-            }
-        });
+            // GET /metrics/mapping (per-rule counters and latency histograms)
+            api.get("/metrics/mapping", [mappingNamespace] APPLICATION(req, res) {
+                res->status(200).json(mappingNamespace->getMqttMapper()->getMetrics()->toJson());
+            });
 
-        // PATCH /config (legacy default draft)
-        api.patch("/config", [configApplication, adminStorageRoot] APPLICATION(req, res) {
-            handleLegacyDefaultDraftMutation(
-                req,
-                res,
-                "patched",
-                "Patch application failed",
-                [adminStorageRoot, configApplication](const nlohmann::json& payload, const std::string& draftId) {
-                    JsonMappingReader::patchDraftWithAutoCreate(adminStorageRoot, configApplication, draftId, payload, std::nullopt);
-                });
-        });
+            // POST /metrics/mapping/reset
+            api.post("/metrics/mapping/reset", [mappingNamespace] APPLICATION(req, res) {
+                mappingNamespace->getMqttMapper()->getMetrics()->reset();
 
-        // POST /config (legacy replace full draft)
-        api.post("/config", [configApplication, adminStorageRoot] APPLICATION(req, res) {
-            handleLegacyDefaultDraftMutation(
-                req,
-                res,
-                "replaced",
-                "Config replacement failed",
-                [adminStorageRoot, configApplication](const nlohmann::json& payload, const std::string& draftId) {
-                    JsonMappingReader::replaceDraftWithAutoCreate(adminStorageRoot, configApplication, draftId, payload, std::nullopt);
-                });
+                res->status(200).json({{"reset", true}});
+            });
+        }
+
+    } // namespace
+
+    express::Router makeMappingAdminRouter(ConfigApplication* configApplication,
+                                           const AdminOptions& opt,
+                                           ReloadCallback onDeploy,
+                                           const RoutesCallback& addApplicationRoutes) {
+        express::Router api;
+
+        api.use(express::middleware::JsonMiddleware());
+        api.use(express::middleware::BasicAuthentication(opt.user, opt.pass, opt.realm));
+
+        // Wall time of the admin handlers, which run on the event loop
+        api.use([adminTime = &LoopMonitor::instance().getSection("admin")] MIDDLEWARE(req, res, next) {
+            const LoopMonitor::Timing timing(*adminTime);
+
+            next();
         });
 
-        // POST /config/deploy (legacy wrapper)
-        api.post("/config/deploy", [configApplication, adminStorageRoot, onDeploy] APPLICATION(req, res) {
-            handleDeployRequest(req, res, configApplication, adminStorageRoot, onDeploy);
+        // GET /schema
+        api.get("/schema", [] APPLICATION(req, res) {
+            res->status(200).send(MqttMapper::getSchema());
         });
 
         // POST /config/validate
@@ -506,58 +597,33 @@ namespace mqtt::lib::admin {
             }
         });
 
-        // GET /config/validateDraft (legacy wrapper)
-        api.get("/config/validateDraft", [adminStorageRoot] APPLICATION(req, res) {
-            handleDraftValidationRequest(res, adminStorageRoot, "No draft configuration available", []() {
-                return std::string(DEFAULT_DRAFT_ID);
-            });
+        // GET /namespaces
+        api.get("/namespaces", [configApplication] APPLICATION(req, res) {
+            nlohmann::json namespaces = nlohmann::json::array();
+            for (const std::shared_ptr<MappingNamespace>& mappingNamespace : configApplication->getMappingNamespaces()->getAll()) {
+                namespaces.push_back({{"name", mappingNamespace->getName()},
+                                      {"revision", mappingNamespace->getMqttMapper()->getRevision()},
+                                      {"owns_connection", mappingNamespace->ownsConnection()}});
+            }
+            res->status(200).json(namespaces);
         });
 
-        // POST /config/rollback
-        api.post("/config/rollback", [configApplication, adminStorageRoot, onDeploy] APPLICATION(req, res) {
-            try {
-                auto jsonBody = parseJsonBody(req);
+        // The default namespace is served at the root, every further namespace below /ns/<name>
+        for (const std::shared_ptr<MappingNamespace>& mappingNamespace : configApplication->getMappingNamespaces()->getAll()) {
+            const std::string adminStorageRoot = buildAdminStorageRoot(configApplication, mappingNamespace.get());
 
-                const std::optional<std::string> snapshotId = resolveSnapshotId(jsonBody);
-                if (!snapshotId) {
-                    res->status(400).json({{"error", "Missing snapshot_id"}, {"details", "Provide snapshot_id"}});
-                    return;
-                }
-                const std::optional<std::uint64_t> expectedRevision = resolveExpectedRevision(req, &jsonBody);
-
-                const mqtt::lib::JsonMappingReader::ApplyResult applyResult =
-                    mqtt::lib::JsonMappingReader::rollbackAndApplyVersion(
-                        adminStorageRoot, configApplication, *snapshotId, expectedRevision);
-
-                const MappingApplyResult responseResult = toMappingApplyResult(applyResult, onDeploy);
-                setRevisionHeaders(res, responseResult.revision);
-                res->status(200).json(makeDeployAckResponse(responseResult));
-            } catch (const nlohmann::json::parse_error& e) {
-                res->status(400).json({{"error", "Invalid JSON body"}, {"details", e.what()}});
-            } catch (const OCCConflictError& e) {
-                respondRevisionConflict(res, e.what(), [&]() -> std::optional<std::uint64_t> {
-                    return configApplication->getMqttMapper()->getRevision();
-                });
-            } catch (const EntityNotFoundError& e) {
-                res->status(404).json({{"error", "Snapshot not found"}, {"details", e.what()}});
-            } catch (const std::exception& e) {
-                res->status(500).json({{"error", "Rollback failed"}, {"details", e.what()}});
+            if (mappingNamespace == configApplication->getDefaultMappingNamespace()) {
+                addNamespaceRoutes(api, mappingNamespace.get(), adminStorageRoot, onDeploy);
+            } else {
+                express::Router namespaceApi;
+                addNamespaceRoutes(namespaceApi, mappingNamespace.get(), adminStorageRoot, onDeploy);
+                api.use("/ns/" + mappingNamespace->getName(), namespaceApi);
             }
-        });
+        }
 
-        // GET /config/history
-        api.get("/config/history", [adminStorageRoot] APPLICATION(req, res) {
-            try {
-                auto history = JsonMappingReader::getHistory(adminStorageRoot);
-                nlohmann::json list = nlohmann::json::array();
-                for (const auto& h : history) {
-                    list.push_back({{"snapshot_id", h.snapshotId}, {"comment", h.comment}, {"date", h.date}});
-                }
-                res->status(200).json(list);
-            } catch ([[maybe_unused]] const std::exception& e) {
-                res->status(500).json({{"error", "Failed to fetch history"}});
-            }
-        });
+        if (addApplicationRoutes) {
+            addApplicationRoutes(api);
+        }
 
         api.get("/", [] APPLICATION(req, res) {
             res->redirect("/ui");
@@ -74,8 +74,15 @@ namespace mqtt::lib::admin {
     // Callback to trigger reload in the main application
     using ReloadCallback = std::function<ReloadResult(bool)>;
 
-    // Creates and returns a Router that handles /config/* endpoints.
-    express::Router makeMappingAdminRouter(ConfigApplication* configApplication, const AdminOptions& opt, ReloadCallback onDeploy = {});
+    // Callback adding application specific routes behind the authentication of the admin API
+    using RoutesCallback = std::function<void(express::Router&)>;
+
+    // Creates and returns a Router that handles /config/* endpoints. The default mapping namespace is served at the root, further
+    // namespaces of the application below /ns/<name>/.
+    express::Router makeMappingAdminRouter(ConfigApplication* configApplication,
+                                           const AdminOptions& opt,
+                                           ReloadCallback onDeploy = {},
+                                           const RoutesCallback& addApplicationRoutes = {});
 
 } // namespace mqtt::lib::admin
 
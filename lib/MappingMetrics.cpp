@@ -0,0 +1,131 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "MappingMetrics.h"
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <nlohmann/json.hpp>
+
+#endif
+
+namespace mqtt::lib {
+
+    MappingMetrics::RuleMetrics::RuleMetrics(const std::string& topic, const std::string& type, std::size_t index)
+        : topic(topic)
+        , type(type)
+        , index(index) {
+    }
+
+    void MappingMetrics::RuleMetrics::reset() {
+        matches.store(0, std::memory_order_relaxed);
+        emitted.store(0, std::memory_order_relaxed);
+        suppressed.store(0, std::memory_order_relaxed);
+        renderErrors.store(0, std::memory_order_relaxed);
+        parseFailures.store(0, std::memory_order_relaxed);
+        rateLimited.store(0, std::memory_order_relaxed);
+        coalesced.store(0, std::memory_order_relaxed);
+
+        latency.reset();
+    }
+
+    nlohmann::json MappingMetrics::RuleMetrics::toJson() const {
+        return {{"topic", topic},
+                {"type", type},
+                {"index", index},
+                {"matches", matches.load(std::memory_order_relaxed)},
+                {"emitted", emitted.load(std::memory_order_relaxed)},
+                {"suppressed", suppressed.load(std::memory_order_relaxed)},
+                {"render_errors", renderErrors.load(std::memory_order_relaxed)},
+                {"parse_failures", parseFailures.load(std::memory_order_relaxed)},
+                {"rate_limited", rateLimited.load(std::memory_order_relaxed)},
+                {"coalesced", coalesced.load(std::memory_order_relaxed)},
+                {"latency", latency.toJson()}};
+    }
+
+    void MappingMetrics::beginMapping() {
+        for (auto& [name, ruleMetrics] : rules) {
+            ruleMetrics->active = false;
+        }
+    }
+
+    MappingMetrics::RuleMetrics* MappingMetrics::registerRule(const std::string& topic, const std::string& type, std::size_t index) {
+        std::unique_ptr<RuleMetrics>& ruleMetrics = rules[topic + "#" + type + "[" + std::to_string(index) + "]"];
+
+        if (ruleMetrics == nullptr) {
+            ruleMetrics = std::make_unique<RuleMetrics>(topic, type, index);
+        }
+        ruleMetrics->active = true;
+
+        return ruleMetrics.get();
+    }
+
+    void MappingMetrics::reset() {
+        for (auto& [name, ruleMetrics] : rules) {
+            ruleMetrics->reset();
+        }
+    }
+
+    nlohmann::json MappingMetrics::toJson() const {
+        nlohmann::json rulesJson = nlohmann::json::array();
+
+        for (const auto& [name, ruleMetrics] : rules) {
+            if (ruleMetrics->active) {
+                rulesJson.push_back(ruleMetrics->toJson());
+            }
+        }
+
+        return {{"rules", rulesJson}};
+    }
+
+    std::vector<const MappingMetrics::RuleMetrics*> MappingMetrics::getActiveRules() const {
+        std::vector<const RuleMetrics*> activeRules;
+
+        for (const auto& [name, ruleMetrics] : rules) {
+            if (ruleMetrics->active) {
+                activeRules.push_back(ruleMetrics.get());
+            }
+        }
+
+        return activeRules;
+    }
+
+} // namespace mqtt::lib
@@ -0,0 +1,105 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTBROKER_LIB_MAPPINGMETRICS_H
+#define MQTTBROKER_LIB_MAPPINGMETRICS_H
+
+#include "LatencyHistogram.h"
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <nlohmann/json_fwd.hpp> // IWYU pragma: export
+#include <string>
+#include <vector>
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+namespace mqtt::lib {
+
+    // Lock-free per-rule counters and latency histograms. Rules are registered while a mapping is activated (event loop), the
+    // counters are updated with relaxed atomics from whatever thread evaluates the mapping.
+    class MappingMetrics {
+    public:
+        struct RuleMetrics {
+            RuleMetrics(const std::string& topic, const std::string& type, std::size_t index);
+
+            void reset();
+            nlohmann::json toJson() const;
+
+            const std::string topic;
+            const std::string type;
+            const std::size_t index;
+
+            std::atomic<std::uint64_t> matches = 0;
+            std::atomic<std::uint64_t> emitted = 0;
+            std::atomic<std::uint64_t> suppressed = 0;
+            std::atomic<std::uint64_t> renderErrors = 0;
+            std::atomic<std::uint64_t> parseFailures = 0;
+            std::atomic<std::uint64_t> rateLimited = 0; // dropped by the rate limit of the rule
+            std::atomic<std::uint64_t> coalesced = 0;   // merged into a publish already waiting for the rate limit
+
+            LatencyHistogram latency; // match plus render
+
+            bool active = false;
+        };
+
+        void beginMapping(); // marks all rules inactive until they are registered again
+
+        RuleMetrics* registerRule(const std::string& topic, const std::string& type, std::size_t index);
+
+        void reset();
+        nlohmann::json toJson() const;
+
+        std::vector<const RuleMetrics*> getActiveRules() const;
+
+    private:
+        // Entries are never removed, so that workers still evaluating an old mapping never touch freed metrics
+        std::map<std::string, std::unique_ptr<RuleMetrics>> rules;
+    };
+
+} // namespace mqtt::lib
+
+#endif // MQTTBROKER_LIB_MAPPINGMETRICS_H
@@ -0,0 +1,279 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "MappingNamespace.h"
+
+#include "MqttMapper.h"
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include "log/Logger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+namespace mqtt::lib {
+
+    MappingNamespace::MappingNamespace(const std::string& name, bool connectionOwner)
+        : name(name)
+        , connectionOwner(connectionOwner)
+        , mqttMapper(std::make_shared<MqttMapper>()) {
+    }
+
+    const std::string& MappingNamespace::getName() const {
+        return name;
+    }
+
+    bool MappingNamespace::ownsConnection() const {
+        return connectionOwner;
+    }
+
+    const std::shared_ptr<MqttMapper>& MappingNamespace::getMqttMapper() const {
+        return mqttMapper;
+    }
+
+    bool MappingNamespace::setMapping(const nlohmann::json& mappingJson) {
+        const bool mustReconnect = mqttMapper->setMapping(mappingJson) && connectionOwner;
+
+        if (onMappingChanged) {
+            onMappingChanged();
+        }
+
+        return mustReconnect;
+    }
+
+    void MappingNamespace::setMappingFile(const std::string& mappingFile) {
+        this->mappingFile = mappingFile;
+    }
+
+    const std::string& MappingNamespace::getMappingFile() const {
+        return mappingFile;
+    }
+
+    bool MappingNamespace::persistMapping() const {
+        bool success = false;
+
+        std::ofstream mapFile(mappingFile, std::ios::trunc);
+        if (mapFile.is_open()) {
+            try {
+                mapFile << mqttMapper->getMapping().dump(2);
+                mapFile.close();
+
+                VLOG(1) << "Write mapping file of namespace '" << name << "' success";
+
+                success = true;
+            } catch (const std::exception& e) {
+                mapFile.close();
+
+                VLOG(1) << "Write mapping file of namespace '" << name << "' failed: " << e.what();
+            }
+        } else {
+            VLOG(1) << "Cannot open mapping file of namespace '" << name << "' for writing: " << mappingFile;
+        }
+
+        return success;
+    }
+
+    bool MappingNamespace::loadMapping() {
+        bool success = false;
+
+        if (!mappingFile.empty()) {
+            std::ifstream mapFile(mappingFile);
+
+            if (mapFile.is_open()) {
+                VLOG(1) << "Mapping file of namespace '" << name << "': " << mappingFile;
+
+                try {
+                    nlohmann::json mappingJson;
+                    mapFile >> mappingJson;
+
+                    setMapping(mappingJson);
+
+                    VLOG(1) << "Load mapping file success";
+
+                    success = true;
+                } catch (const std::exception& e) {
+                    VLOG(1) << "Load mapping file failed: " << e.what() << " at " << mapFile.tellg();
+                }
+
+                mapFile.close();
+            } else {
+                VLOG(1) << "Mapping file of namespace '" << name << "': " << mappingFile << " not found";
+            }
+        }
+
+        return success;
+    }
+
+    MappingNamespaces::MappingNamespaces(const std::shared_ptr<MappingNamespace>& defaultNamespace) {
+        add(defaultNamespace);
+    }
+
+    MappingNamespaces::~MappingNamespaces() {
+        for (const std::shared_ptr<MappingNamespace>& mappingNamespace : mappingNamespaces) {
+            mappingNamespace->onMappingChanged = nullptr;
+        }
+    }
+
+    const std::shared_ptr<MappingNamespace>& MappingNamespaces::getDefault() const {
+        return mappingNamespaces.front();
+    }
+
+    const std::vector<std::shared_ptr<MappingNamespace>>& MappingNamespaces::getAll() const {
+        return mappingNamespaces;
+    }
+
+    MappingNamespace* MappingNamespaces::find(std::string_view name) const {
+        const auto it = std::find_if(mappingNamespaces.begin(), mappingNamespaces.end(), [name](const auto& mappingNamespace) {
+            return mappingNamespace->getName() == name;
+        });
+
+        return it != mappingNamespaces.end() ? it->get() : nullptr;
+    }
+
+    void MappingNamespaces::add(const std::shared_ptr<MappingNamespace>& mappingNamespace) {
+        if (find(mappingNamespace->getName()) != nullptr) {
+            throw std::runtime_error("Mapping namespace '" + mappingNamespace->getName() + "' already defined");
+        }
+
+        mappingNamespace->onMappingChanged = [this]() {
+            reindex();
+        };
+        mappingNamespaces.push_back(mappingNamespace);
+
+        reindex();
+    }
+
+    std::list<iot::mqtt::Topic> MappingNamespaces::extractSubscriptions() const {
+        return subscriptions;
+    }
+
+    void MappingNamespaces::reindex() {
+        topicIndex = TopicNode();
+        subscriptions.clear();
+
+        std::map<std::string, uint8_t> mergedSubscriptions; // one subscription per filter with the highest requested QoS
+
+        for (std::size_t index = 0; index < mappingNamespaces.size(); ++index) {
+            for (const iot::mqtt::Topic& topic : mappingNamespaces[index]->getMqttMapper()->extractSubscriptions()) {
+                const std::string& filter = topic.getName();
+
+                TopicNode* node = &topicIndex;
+                for (std::size_t pos = 0; pos != std::string::npos;) {
+                    const std::size_t slash = filter.find('/', pos);
+                    node = &node->children[filter.substr(pos, slash == std::string::npos ? std::string::npos : slash - pos)];
+                    pos = slash == std::string::npos ? std::string::npos : slash + 1;
+                }
+                if (node->namespaces.empty() || node->namespaces.back() != index) {
+                    node->namespaces.push_back(index);
+                }
+
+                auto [it, inserted] = mergedSubscriptions.try_emplace(filter, topic.getQoS());
+                if (!inserted) {
+                    it->second = std::max(it->second, topic.getQoS());
+                }
+            }
+        }
+
+        for (const auto& [filter, qoS] : mergedSubscriptions) {
+            subscriptions.emplace_back(filter, qoS);
+        }
+
+        VLOG(1) << "Mapping namespaces indexed: " << mappingNamespaces.size() << " namespaces, " << subscriptions.size()
+                << " subscriptions";
+    }
+
+    void MappingNamespaces::collect(const TopicNode& node, std::string_view topic, std::size_t pos, std::vector<std::size_t>& hits) const {
+        const bool wildcardsAllowed = pos != 0 || !topic.starts_with('$'); // wildcards at the first level do not match $-topics
+
+        if (wildcardsAllowed) {
+            if (const auto multiLevel = node.children.find("#"); multiLevel != node.children.end()) {
+                hits.insert(hits.end(), multiLevel->second.namespaces.begin(), multiLevel->second.namespaces.end());
+            }
+        }
+
+        if (pos == std::string_view::npos) {
+            hits.insert(hits.end(), node.namespaces.begin(), node.namespaces.end());
+        } else {
+            const std::size_t slash = topic.find('/', pos);
+            const std::string_view level = topic.substr(pos, slash == std::string_view::npos ? std::string_view::npos : slash - pos);
+            const std::size_t nextPos = slash == std::string_view::npos ? std::string_view::npos : slash + 1;
+
+            if (const auto child = node.children.find(level); child != node.children.end()) {
+                collect(child->second, topic, nextPos, hits);
+            }
+
+            if (wildcardsAllowed) {
+                if (const auto singleLevel = node.children.find("+"); singleLevel != node.children.end()) {
+                    collect(singleLevel->second, topic, nextPos, hits);
+                }
+            }
+        }
+    }
+
+    std::vector<MappingNamespace*> MappingNamespaces::match(std::string_view topic) const {
+        std::vector<MappingNamespace*> matches;
+
+        if (mappingNamespaces.size() == 1) {
+            matches.push_back(mappingNamespaces.front().get()); // the mapper itself sorts out non matching topics
+        } else {
+            std::vector<std::size_t> hits;
+            collect(topicIndex, topic, 0, hits);
+
+            std::sort(hits.begin(), hits.end());
+            hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+
+            matches.reserve(hits.size());
+            for (const std::size_t index : hits) {
+                matches.push_back(mappingNamespaces[index].get());
+            }
+        }
+
+        return matches;
+    }
+
+} // namespace mqtt::lib
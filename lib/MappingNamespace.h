@@ -0,0 +1,133 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTBROKER_LIB_MAPPINGNAMESPACE_H
+#define MQTTBROKER_LIB_MAPPINGNAMESPACE_H
+
+namespace mqtt::lib {
+    class MqttMapper;
+}
+
+#include <iot/mqtt/Topic.h> // IWYU pragma: keep
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+namespace mqtt::lib {
+
+    // A named mapping with its own MqttMapper and mapping file. Drafts, revisions and history of a namespace are managed by the
+    // JsonMappingReader in a storage root of its own. Only the namespace owning the connection contributes the "connection" section.
+    class MappingNamespace {
+    public:
+        MappingNamespace(const std::string& name, bool connectionOwner);
+
+        const std::string& getName() const;
+        bool ownsConnection() const;
+
+        const std::shared_ptr<MqttMapper>& getMqttMapper() const;
+
+        bool setMapping(const nlohmann::json& mappingJson); // can throw, returns whether a reconnect is needed
+        void setMappingFile(const std::string& mappingFile);
+        const std::string& getMappingFile() const;
+
+        bool loadMapping();
+        bool persistMapping() const;
+
+    private:
+        friend class MappingNamespaces;
+
+        std::string name;
+        bool connectionOwner;
+        std::string mappingFile;
+        std::shared_ptr<MqttMapper> mqttMapper;
+
+        std::function<void()> onMappingChanged;
+    };
+
+    // All namespaces of one application sharing one upstream connection. The union of their subscriptions is compiled into a
+    // single topic index which tells for a received topic which namespaces have to evaluate it.
+    class MappingNamespaces {
+    public:
+        explicit MappingNamespaces(const std::shared_ptr<MappingNamespace>& defaultNamespace);
+
+        MappingNamespaces(const MappingNamespaces&) = delete;
+        MappingNamespaces& operator=(const MappingNamespaces&) = delete;
+
+        ~MappingNamespaces();
+
+        const std::shared_ptr<MappingNamespace>& getDefault() const;
+        const std::vector<std::shared_ptr<MappingNamespace>>& getAll() const;
+        MappingNamespace* find(std::string_view name) const;
+
+        void add(const std::shared_ptr<MappingNamespace>& mappingNamespace); // can throw on duplicate names
+
+        std::list<iot::mqtt::Topic> extractSubscriptions() const;
+        std::vector<MappingNamespace*> match(std::string_view topic) const; // in namespace order
+
+    private:
+        struct TopicNode {
+            std::map<std::string, TopicNode, std::less<>> children; // wildcards '+' and '#' are children too
+            std::vector<std::size_t> namespaces;                    // indices of namespaces subscribed to this node
+        };
+
+        void reindex();
+        void collect(const TopicNode& node, std::string_view topic, std::size_t pos, std::vector<std::size_t>& hits) const;
+
+        std::vector<std::shared_ptr<MappingNamespace>> mappingNamespaces;
+
+        TopicNode topicIndex;
+        std::list<iot::mqtt::Topic> subscriptions;
+    };
+
+} // namespace mqtt::lib
+
+#endif // MQTTBROKER_LIB_MAPPINGNAMESPACE_H
@@ -0,0 +1,316 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "MappingWorkerPool.h"
+
+#include <core/eventreceiver/ReadEventReceiver.h>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <log/Logger.h>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+#endif
+
+namespace mqtt::lib {
+
+    class MappingWorkerPool::Worker {
+    public:
+        Worker(const nlohmann::json& mappingJson,
+               const std::shared_ptr<MappingMetrics>& mappingMetrics,
+               const std::shared_ptr<RateLimiter>& rateLimiter,
+               ResultQueue& resultQueue,
+               int eventFd);
+        Worker(const Worker&) = delete;
+        Worker& operator=(const Worker&) = delete;
+
+        ~Worker(); // processes all queued jobs before returning
+
+        void enqueue(const iot::mqtt::packets::Publish& publish, const MqttMapper::MappedCallback& onMapped, const void* origin);
+
+    private:
+        struct Job {
+            iot::mqtt::packets::Publish publish;
+            MqttMapper::MappedCallback onMapped;
+            const void* origin;
+        };
+
+        void run();
+
+        MqttMapper mqttMapper;
+        ResultQueue& resultQueue;
+        int eventFd;
+
+        std::mutex jobsMutex;
+        std::condition_variable jobsCondition;
+        std::deque<Job> jobs;
+        bool stopping = false;
+
+        std::thread thread;
+    };
+
+    class MappingWorkerPool::CompletionReceiver : public core::eventreceiver::ReadEventReceiver {
+    public:
+        CompletionReceiver(MappingWorkerPool* mappingWorkerPool, int eventFd)
+            : core::eventreceiver::ReadEventReceiver("MappingWorkerPool", core::DescriptorEventReceiver::TIMEOUT::DISABLE)
+            , mappingWorkerPool(mappingWorkerPool)
+            , eventFd(eventFd) {
+            if (!enable(eventFd)) {
+                this->mappingWorkerPool = nullptr;
+            }
+        }
+
+        ~CompletionReceiver() override {
+            close(eventFd);
+        }
+
+        void detach() {
+            mappingWorkerPool = nullptr;
+
+            if (isEnabled()) {
+                disable();
+            } else {
+                delete this;
+            }
+        }
+
+    private:
+        void readEvent() override {
+            eventfd_t count = 0;
+            eventfd_read(eventFd, &count);
+
+            if (mappingWorkerPool != nullptr) {
+                mappingWorkerPool->deliverResults();
+            }
+        }
+
+        void unobservedEvent() override {
+            if (mappingWorkerPool != nullptr) {
+                mappingWorkerPool->completionReceiver = nullptr;
+            }
+
+            delete this;
+        }
+
+        MappingWorkerPool* mappingWorkerPool;
+        int eventFd;
+    };
+
+    MappingWorkerPool::MappingWorkerPool(std::size_t workerCount,
+                                         const std::shared_ptr<MappingMetrics>& mappingMetrics,
+                                         const std::shared_ptr<RateLimiter>& rateLimiter)
+        : workerCount(workerCount)
+        , mappingMetrics(mappingMetrics)
+        , rateLimiter(rateLimiter)
+        , eventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+        if (eventFd < 0) {
+            throw std::runtime_error(std::string("Creating eventfd for mapping workers failed: ") + std::strerror(errno));
+        }
+
+        completionReceiver = new CompletionReceiver(this, eventFd);
+
+        VLOG(1) << "Mapping worker pool created with " << workerCount << " worker threads";
+    }
+
+    MappingWorkerPool::~MappingWorkerPool() {
+        workers.clear();
+
+        if (completionReceiver != nullptr) {
+            completionReceiver->detach();
+        }
+
+        // The owners of not yet delivered results may already be gone - drop them
+        while (Result* result = resultQueue.pop()) {
+            delete result;
+        }
+    }
+
+    void MappingWorkerPool::setMapping(const nlohmann::json& mappingJson) {
+        workers.clear();
+
+        for (std::size_t i = 0; i < workerCount; i++) {
+            workers.push_back(std::make_unique<Worker>(mappingJson, mappingMetrics, rateLimiter, resultQueue, eventFd));
+        }
+    }
+
+    void MappingWorkerPool::dispatch(const iot::mqtt::packets::Publish& publish,
+                                     const MqttMapper::MappedCallback& onMapped,
+                                     const void* origin) {
+        workers[std::hash<std::string>{}(publish.getTopic()) % workers.size()]->enqueue(publish, onMapped, origin);
+    }
+
+    std::size_t MappingWorkerPool::getWorkerCount() const {
+        return workerCount;
+    }
+
+    void MappingWorkerPool::deliverResults() {
+        while (Result* result = resultQueue.pop()) {
+            const std::unique_ptr<Result> deliveredResult(result);
+
+            deliveredResult->onMapped(std::move(deliveredResult->mappedPublishes));
+        }
+    }
+
+    MappingWorkerPool::Worker::Worker(const nlohmann::json& mappingJson,
+                                      const std::shared_ptr<MappingMetrics>& mappingMetrics,
+                                      const std::shared_ptr<RateLimiter>& rateLimiter,
+                                      ResultQueue& resultQueue,
+                                      int eventFd)
+        : resultQueue(resultQueue)
+        , eventFd(eventFd) {
+        mqttMapper.setMetrics(mappingMetrics);  // all workers count into the metrics of the owning mapper
+        mqttMapper.setRateLimiter(rateLimiter); // and share its token buckets
+        mqttMapper.setMapping(mappingJson); // on the event loop as plugins are loaded here
+
+        thread = std::thread(&Worker::run, this);
+    }
+
+    MappingWorkerPool::Worker::~Worker() {
+        {
+            const std::scoped_lock<std::mutex> jobsLock(jobsMutex);
+            stopping = true;
+        }
+        jobsCondition.notify_one();
+
+        thread.join();
+    }
+
+    void MappingWorkerPool::Worker::enqueue(const iot::mqtt::packets::Publish& publish,
+                                            const MqttMapper::MappedCallback& onMapped,
+                                            const void* origin) {
+        {
+            const std::scoped_lock<std::mutex> jobsLock(jobsMutex);
+            jobs.push_back({publish, onMapped, origin});
+        }
+        jobsCondition.notify_one();
+    }
+
+    void MappingWorkerPool::Worker::run() {
+        std::unique_lock<std::mutex> jobsLock(jobsMutex);
+
+        for (;;) {
+            jobsCondition.wait(jobsLock, [this]() {
+                return stopping || !jobs.empty();
+            });
+
+            if (jobs.empty()) {
+                break;
+            }
+
+            Job job = std::move(jobs.front());
+            jobs.pop_front();
+            jobsLock.unlock();
+
+            Result* result = new Result;
+            try {
+                result->mappedPublishes = mqttMapper.getMappings(job.publish, job.origin);
+            } catch (const std::exception& e) {
+                VLOG(1) << "Mapping worker: Mapping of topic '" << job.publish.getTopic() << "' failed: " << e.what();
+            }
+            result->onMapped = std::move(job.onMapped);
+
+            resultQueue.push(result);
+            eventfd_write(eventFd, 1);
+
+            jobsLock.lock();
+        }
+    }
+
+    // Intrusive MPSC queue after Dmitry Vyukov: producers only exchange the head, the single consumer owns the tail
+    MappingWorkerPool::ResultQueue::ResultQueue()
+        : head(&stub)
+        , tail(&stub) {
+    }
+
+    MappingWorkerPool::ResultQueue::~ResultQueue() {
+        while (Result* result = pop()) {
+            delete result;
+        }
+    }
+
+    void MappingWorkerPool::ResultQueue::push(Result* result) {
+        result->next.store(nullptr, std::memory_order_relaxed);
+
+        Result* previous = head.exchange(result, std::memory_order_acq_rel);
+        previous->next.store(result, std::memory_order_release);
+    }
+
+    MappingWorkerPool::Result* MappingWorkerPool::ResultQueue::pop() {
+        Result* result = nullptr;
+
+        Result* first = tail;
+        Result* next = first->next.load(std::memory_order_acquire);
+
+        if (first == &stub && next != nullptr) {
+            tail = next;
+            first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (first != &stub) {
+            if (next == nullptr && first == head.load(std::memory_order_acquire)) {
+                push(&stub);
+                next = first->next.load(std::memory_order_acquire);
+            }
+
+            // next == nullptr: a producer is in the middle of a push - it signals the eventfd afterwards
+            if (next != nullptr) {
+                tail = next;
+                result = first;
+            }
+        }
+
+        return result;
+    }
+
+} // namespace mqtt::lib
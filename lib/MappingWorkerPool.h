@@ -0,0 +1,121 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTBROKER_LIB_MAPPINGWORKERPOOL_H
+#define MQTTBROKER_LIB_MAPPINGWORKERPOOL_H
+
+#include "MqttMapper.h"
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <nlohmann/json_fwd.hpp>
+#include <vector>
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+namespace mqtt::lib {
+
+    // Evaluates mappings on a fixed number of worker threads. Each worker owns a private MqttMapper, thus a private inja
+    // environment and plugin registration. Publishes are assigned to workers by the hash of their topic, so results for the same
+    // source topic are delivered in order. Results are handed back to the event loop via a lock-free MPSC queue and an eventfd.
+    // The rate limiter of the owning mapper is shared by all workers, so a rate limit holds for the pool as a whole and is not
+    // multiplied by the number of workers.
+    class MappingWorkerPool {
+    public:
+        MappingWorkerPool(std::size_t workerCount,
+                          const std::shared_ptr<MappingMetrics>& mappingMetrics,
+                          const std::shared_ptr<RateLimiter>& rateLimiter);
+        MappingWorkerPool(const MappingWorkerPool&) = delete;
+        MappingWorkerPool& operator=(const MappingWorkerPool&) = delete;
+
+        ~MappingWorkerPool();
+
+        void setMapping(const nlohmann::json& mappingJson); // drains all pending jobs using the old mapping
+        void dispatch(const iot::mqtt::packets::Publish& publish, const MqttMapper::MappedCallback& onMapped, const void* origin);
+
+        std::size_t getWorkerCount() const;
+
+    private:
+        struct Result {
+            std::atomic<Result*> next = nullptr;
+
+            MqttMapper::MappedPublishes mappedPublishes;
+            MqttMapper::MappedCallback onMapped;
+        };
+
+        class ResultQueue {
+        public:
+            ResultQueue();
+            ResultQueue(const ResultQueue&) = delete;
+            ResultQueue& operator=(const ResultQueue&) = delete;
+
+            ~ResultQueue();
+
+            void push(Result* result); // any thread
+            Result* pop();             // event loop only, nullptr if empty
+
+        private:
+            std::atomic<Result*> head;
+            Result* tail;
+            Result stub;
+        };
+
+        class Worker;
+        class CompletionReceiver;
+
+        void deliverResults();
+
+        std::size_t workerCount;
+        std::shared_ptr<MappingMetrics> mappingMetrics;
+        std::shared_ptr<RateLimiter> rateLimiter;
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        ResultQueue resultQueue;
+        CompletionReceiver* completionReceiver;
+        int eventFd;
+    };
+
+} // namespace mqtt::lib
+
+#endif // MQTTBROKER_LIB_MAPPINGWORKERPOOL_H
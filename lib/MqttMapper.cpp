@@ -41,6 +41,7 @@
 
 #include "MqttMapper.h"
 
+#include "MappingWorkerPool.h"
 #include "MqttMapperPlugin.h"
 
 #include <core/DynamicLoader.h>
@@ -50,8 +51,11 @@
 
 #include "nlohmann/json-schema.hpp"
 
+#include <chrono>
 #include <cmath>
 #include <exception>
+#include <ostream>
+#include <streambuf>
 
 #ifdef __GNUC__
 #pragma GCC diagnostic push
@@ -91,17 +95,55 @@
 
 namespace mqtt::lib {
 
+    namespace {
+
+        constexpr std::size_t MAX_INTERNED_TOPICS = 65536;
+
+        // Lets inja render into an existing string, keeping its capacity
+        class StringAppender : public std::streambuf {
+        public:
+            explicit StringAppender(std::string& target)
+                : target(target) {
+            }
+
+        protected:
+            int_type overflow(int_type ch) override {
+                if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+                    target.push_back(traits_type::to_char_type(ch));
+                }
+
+                return traits_type::not_eof(ch);
+            }
+
+            std::streamsize xsputn(const char_type* s, std::streamsize count) override {
+                target.append(s, static_cast<std::size_t>(count));
+
+                return count;
+            }
+
+        private:
+            std::string& target;
+        };
+
+    } // namespace
+
 #include "mapping-schema.json.h" // definition of 'static const std::string mappingJsonSchemaString;'
 
     const nlohmann::json_schema::json_validator
         MqttMapper::validator(nlohmann::json::parse(mappingJsonSchemaString), nullptr, nlohmann::json_schema::default_string_format_check);
 
     MqttMapper::MqttMapper()
-        : injaEnvironment(new inja::Environment) {
+        : rateLimiter(std::make_shared<RateLimiter>())
+        , topicInterner(MAX_INTERNED_TOPICS)
+        , mappingMetrics(std::make_shared<MappingMetrics>())
+        , injaEnvironment(new inja::Environment) {
         setMapping({});
     }
 
     MqttMapper::~MqttMapper() {
+        workerPool.reset();
+        parsedTemplates.clear(); // before unloading the plugins the parsed templates hold callbacks of
+
         delete injaEnvironment;
 
         for (void* pluginHandle : pluginHandles) {
@@ -114,6 +156,8 @@ namespace mqtt::lib {
     }
 
     bool MqttMapper::setMapping(nlohmann::json mappingJson) { // can throw
+        parsedTemplates.clear();
+
         delete injaEnvironment;
 
         for (void* handle : pluginHandles) {
@@ -144,6 +188,17 @@ namespace mqtt::lib {
 
         bool mustReconnect = this->mappingJson["connection"] != oldMappingJson["connection"];
 
+        binaryLayouts.clear();
+        jsonFieldExtractors.clear();
+        if (ownsRateLimiter) {
+            rateLimiter->clear();
+        }
+        ruleMetrics.clear();
+        mappingMetrics->beginMapping();
+        if (this->mappingJson["mapping"].contains("topic_level")) {
+            compileSubscriptions(this->mappingJson["mapping"]["topic_level"], "");
+        }
+
         if (mappingJson["mapping"].contains("plugins")) {
             VLOG(1) << "Loading plugins ...";
             for (const nlohmann::json& pluginJson : mappingJson["mapping"]["plugins"]) {
@@ -202,6 +257,10 @@ namespace mqtt::lib {
             VLOG(1) << "Loading plugins done";
         }
 
+        if (workerPool != nullptr) {
+            workerPool->setMapping(this->mappingJsonUnpatched);
+        }
+
         return mustReconnect;
     }
 
@@ -241,13 +300,17 @@ namespace mqtt::lib {
         return topicList;
     }
 
-    MqttMapper::MappedPublishes MqttMapper::getMappings(const iot::mqtt::packets::Publish& publish) {
+    MqttMapper::MappedPublishes MqttMapper::getMappings(const iot::mqtt::packets::Publish& publish, const void* origin) {
+        this->origin = origin;
+
         MappedPublishes mappedPublishes;
         if (mappingJson.contains("mapping") && !mappingJson["mapping"].empty()) {
-            nlohmann::json matchingTopicLevel = findMatchingTopicLevel(mappingJson["mapping"]["topic_level"], publish.getTopic());
+            const std::chrono::steady_clock::time_point matchStart = std::chrono::steady_clock::now();
+            const nlohmann::json* matchingTopicLevel = findMatchingTopicLevel(mappingJson["mapping"]["topic_level"], publish.getTopic());
+            matchDuration = std::chrono::steady_clock::now() - matchStart;
 
-            if (!matchingTopicLevel.empty()) {
-                const nlohmann::json& subscription = matchingTopicLevel["subscription"];
+            if (matchingTopicLevel != nullptr && matchingTopicLevel->contains("subscription")) {
+                const nlohmann::json& subscription = (*matchingTopicLevel)["subscription"];
 
                 if (subscription.contains("static")) {
                     VLOG(1) << "Topic mapping found for:";
@@ -275,24 +338,19 @@ namespace mqtt::lib {
                 }
 
                 if (subscription.contains("json")) {
-                    VLOG(1) << "Topic mapping found for:";
-                    VLOG(1) << "  Type: json";
-                    VLOG(1) << "  Topic: " << publish.getTopic();
-                    VLOG(1) << "  Message: " << publish.getMessage();
-                    VLOG(1) << "  QoS: " << static_cast<uint16_t>(publish.getQoS());
-                    VLOG(1) << "  Retain: " << publish.getRetain();
+                    getDecodedMappings(subscription["json"], "json", publish, mappedPublishes);
+                }
 
-                    try {
-                        nlohmann::json json;
-                        json["message"] = nlohmann::json::parse(publish.getMessage());
+                if (subscription.contains("cbor")) {
+                    getDecodedMappings(subscription["cbor"], "cbor", publish, mappedPublishes);
+                }
 
-                        getTemplateMappings(subscription["json"], json, publish, mappedPublishes);
-                    } catch (const nlohmann::json::parse_error& e) {
-                        VLOG(1) << "  Parsing message into json failed: " << publish.getMessage();
-                        VLOG(1) << "     What: " << e.what() << '\n'
-                                << "     Exception Id: " << e.id << '\n'
-                                << "     Byte position of error: " << e.byte;
-                    }
+                if (subscription.contains("msgpack")) {
+                    getDecodedMappings(subscription["msgpack"], "msgpack", publish, mappedPublishes);
+                }
+
+                if (subscription.contains("binary")) {
+                    getBinaryMappings(subscription["binary"], publish, mappedPublishes);
                 }
             }
         }
@@ -300,6 +358,42 @@ namespace mqtt::lib {
         return mappedPublishes;
     }
 
+    void MqttMapper::getMappings(const iot::mqtt::packets::Publish& publish, const MappedCallback& onMapped, const void* origin) {
+        if (workerThreads == 0) {
+            onMapped(getMappings(publish, origin));
+        } else {
+            if (workerPool == nullptr) {
+                workerPool = std::make_unique<MappingWorkerPool>(workerThreads, mappingMetrics, rateLimiter);
+                workerPool->setMapping(mappingJsonUnpatched);
+            }
+
+            workerPool->dispatch(publish, onMapped, origin);
+        }
+    }
+
+    void MqttMapper::setWorkerThreads(std::size_t workerThreads) {
+        this->workerThreads = workerThreads;
+
+        workerPool.reset();
+    }
+
+    std::size_t MqttMapper::getWorkerThreads() const {
+        return workerThreads;
+    }
+
+    const std::shared_ptr<MappingMetrics>& MqttMapper::getMetrics() const {
+        return mappingMetrics;
+    }
+
+    void MqttMapper::setMetrics(const std::shared_ptr<MappingMetrics>& mappingMetrics) {
+        this->mappingMetrics = mappingMetrics;
+    }
+
+    void MqttMapper::setRateLimiter(const std::shared_ptr<RateLimiter>& rateLimiter) {
+        this->rateLimiter = rateLimiter;
+        ownsRateLimiter = false;
+    }
+
     const nlohmann::json MqttMapper::validate(const nlohmann::json& json) {
         return validator.validate(json);
     }
@@ -339,16 +433,94 @@ namespace mqtt::lib {
         }
     }
 
-    nlohmann::json MqttMapper::findMatchingTopicLevel(const nlohmann::json& topicLevel, const std::string& topic) {
-        nlohmann::json foundTopicLevel;
+    void MqttMapper::compileSubscriptions(const nlohmann::json& topicLevelJson, const std::string& topic) {
+        if (topicLevelJson.is_array()) {
+            for (const nlohmann::json& topicLevelEntry : topicLevelJson) {
+                compileSubscriptions(topicLevelEntry, topic);
+            }
+        } else if (topicLevelJson.is_object()) {
+            const std::string& name = topicLevelJson["name"];
+            const std::string levelTopic = topic + ((topic.empty() || topic == "/") && !name.empty() ? "" : "/") + name;
+
+            if (topicLevelJson.contains("subscription")) {
+                const nlohmann::json& subscription = topicLevelJson["subscription"];
+
+                for (const char* type : {"static", "value", "json", "cbor", "msgpack"}) {
+                    if (subscription.contains(type)) {
+                        registerRuleMetrics(subscription[type], levelTopic, type);
+                    }
+                }
+
+                if (subscription.contains("binary")) {
+                    const nlohmann::json& binaryJson = subscription["binary"];
+
+                    binaryLayouts.emplace(&binaryJson, BinaryLayout(binaryJson));
+                    registerRuleMetrics(binaryJson["mapping"], levelTopic, "binary");
+                }
+
+                if (subscription.contains("json")) {
+                    const nlohmann::json& jsonMapping = subscription["json"];
+
+                    JsonFieldExtractor& jsonFieldExtractor = jsonFieldExtractors[&jsonMapping];
+                    for (const nlohmann::json& templateMapping :
+                         jsonMapping.is_array() ? jsonMapping : nlohmann::json::array({jsonMapping})) {
+                        jsonFieldExtractor.addTemplate(templateMapping["mapped_topic"]);
+                        jsonFieldExtractor.addTemplate(templateMapping["mapping_template"]);
+                    }
+                }
+            }
+
+            if (topicLevelJson.contains("topic_level")) {
+                compileSubscriptions(topicLevelJson["topic_level"], levelTopic);
+            }
+        }
+    }
+
+    void MqttMapper::registerRuleMetrics(const nlohmann::json& ruleJson, const std::string& topic, const std::string& type) {
+        if (ruleJson.is_array()) {
+            for (std::size_t index = 0; index < ruleJson.size(); index++) {
+                ruleMetrics[&ruleJson[index]] = mappingMetrics->registerRule(topic, type, index);
+            }
+        } else {
+            ruleMetrics[&ruleJson] = mappingMetrics->registerRule(topic, type, 0);
+        }
+    }
+
+    MappingMetrics::RuleMetrics& MqttMapper::getRuleMetrics(const nlohmann::json& ruleJson) {
+        const auto ruleMetricsIt = ruleMetrics.find(&ruleJson);
+
+        return ruleMetricsIt != ruleMetrics.end() ? *ruleMetricsIt->second : unregisteredRuleMetrics;
+    }
+
+    void MqttMapper::recordLatency(MappingMetrics::RuleMetrics& ruleMetrics, std::chrono::steady_clock::time_point ruleStart) const {
+        ruleMetrics.latency.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(matchDuration + (std::chrono::steady_clock::now() - ruleStart)).count()));
+    }
+
+    void MqttMapper::countParseFailure(const nlohmann::json& ruleJson) {
+        if (ruleJson.is_array()) {
+            for (const nlohmann::json& concreteRuleJson : ruleJson) {
+                countParseFailure(concreteRuleJson);
+            }
+        } else {
+            MappingMetrics::RuleMetrics& concreteRuleMetrics = getRuleMetrics(ruleJson);
+
+            concreteRuleMetrics.matches.fetch_add(1, std::memory_order_relaxed);
+            concreteRuleMetrics.parseFailures.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    const nlohmann::json* MqttMapper::findMatchingTopicLevel(const nlohmann::json& topicLevel, std::string_view topic) {
+        const nlohmann::json* foundTopicLevel = nullptr;
 
         if (topicLevel.is_object()) {
-            const std::string::size_type slashPosition = topic.find('/');
-            const std::string topicLevelName = topic.substr(0, slashPosition);
+            const std::string_view::size_type slashPosition = topic.find('/');
+            const std::string_view topicLevelName = topic.substr(0, slashPosition);
+            const std::string& name = topicLevel["name"].get_ref<const std::string&>();
 
-            if (topicLevel["name"] == topicLevelName || topicLevel["name"] == "+" || topicLevel["name"] == "#") {
-                if (slashPosition == std::string::npos) {
-                    foundTopicLevel = topicLevel;
+            if (name == topicLevelName || name == "+" || name == "#") {
+                if (slashPosition == std::string_view::npos) {
+                    foundTopicLevel = &topicLevel;
                 } else if (topicLevel.contains("topic_level")) {
                     foundTopicLevel = findMatchingTopicLevel(topicLevel["topic_level"], topic.substr(slashPosition + 1));
                 }
@@ -357,7 +529,7 @@ namespace mqtt::lib {
             for (const nlohmann::json& topicLevelEntry : topicLevel) {
                 foundTopicLevel = findMatchingTopicLevel(topicLevelEntry, topic);
 
-                if (!foundTopicLevel.empty()) {
+                if (foundTopicLevel != nullptr) {
                     break;
                 }
             }
@@ -366,21 +538,51 @@ namespace mqtt::lib {
         return foundTopicLevel;
     }
 
+    const inja::Template& MqttMapper::getParsedTemplate(const nlohmann::json& templateString) {
+        std::unique_ptr<inja::Template>& parsedTemplate = parsedTemplates[&templateString];
+
+        if (parsedTemplate == nullptr) {
+            try {
+                parsedTemplate = std::make_unique<inja::Template>(injaEnvironment->parse(templateString.get_ref<const std::string&>()));
+            } catch (const inja::InjaError&) {
+                parsedTemplates.erase(&templateString);
+                throw;
+            }
+        }
+
+        return *parsedTemplate;
+    }
+
     void MqttMapper::getMappedTemplate(const nlohmann::json& templateMapping, nlohmann::json& json, MappedPublishes& mappedPublishes) {
         const std::string& mappingTemplate = templateMapping["mapping_template"];
         const std::string& mappedTopic = templateMapping["mapped_topic"];
 
+        MappingMetrics::RuleMetrics& templateRuleMetrics = getRuleMetrics(templateMapping);
+        templateRuleMetrics.matches.fetch_add(1, std::memory_order_relaxed);
+        const std::chrono::steady_clock::time_point ruleStart = std::chrono::steady_clock::now();
+
         try {
             // Render topic
-            const std::string renderedTopic = injaEnvironment->render(mappedTopic, json);
-            json["mapped_topic"] = renderedTopic;
+            renderedTopic.clear();
+            StringAppender renderedTopicAppender(renderedTopic);
+            std::ostream renderedTopicStream(&renderedTopicAppender);
+            injaEnvironment->render_to(renderedTopicStream, getParsedTemplate(templateMapping["mapped_topic"]), json);
+
+            const TopicInterner::InternedTopic internedTopic = topicInterner.intern(renderedTopic);
+            // Assigned in place, so that the fan-out entries of one render context reuse the same string
+            nlohmann::json& mappedTopicJson = json["mapped_topic"];
+            if (mappedTopicJson.is_string()) {
+                mappedTopicJson.get_ref<std::string&>().assign(internedTopic.name);
+            } else {
+                mappedTopicJson = std::string(internedTopic.name);
+            }
 
             VLOG(1) << "  Mapped topic template: " << mappedTopic;
-            VLOG(1) << "    -> " << renderedTopic;
+            VLOG(1) << "    -> " << internedTopic.name;
 
             try {
                 // Render message
-                const std::string renderedMessage = injaEnvironment->render(mappingTemplate, json);
+                const std::string renderedMessage = injaEnvironment->render(getParsedTemplate(templateMapping["mapping_template"]), json);
                 VLOG(1) << "  Mapped message template: " << mappingTemplate;
                 VLOG(1) << "    -> " << renderedMessage;
 
@@ -391,34 +593,108 @@ namespace mqtt::lib {
                     (retain && renderedMessage.empty())) {
                     const uint8_t qoS = templateMapping["qos"];
                     const double delay = templateMapping["delay"];
+                    const std::string& encoding = templateMapping["encoding"];
 
                     VLOG(1) << "  Send mapping:" << (delay > 0 ? " delayed" : "");
-                    VLOG(1) << "    Topic: " << renderedTopic;
+                    VLOG(1) << "    Topic: " << internedTopic.name;
                     VLOG(1) << "    Message: " << renderedMessage << "";
                     VLOG(1) << "    QoS: " << static_cast<int>(qoS);
                     VLOG(1) << "    retain: " << retain;
                     VLOG(1) << "    Delay: " << delay;
+                    VLOG(1) << "    Encoding: " << encoding;
 
-                    getMappedMessage(renderedTopic, renderedMessage, qoS, retain, delay, mappedPublishes);
+                    if (getMappedMessage(templateMapping, internedTopic, renderedMessage, qoS, retain, delay, encoding, mappedPublishes)) {
+                        templateRuleMetrics.emitted.fetch_add(1, std::memory_order_relaxed);
+                    }
                 } else {
                     VLOG(1) << "    Rendered message: '" << renderedMessage << "' in suppression list:";
                     for (const nlohmann::json& item : suppressions) {
                         VLOG(1) << "         '" << item.get<std::string>() << "'";
                     }
                     VLOG(1) << "  Send mapping: suppressed";
+                    templateRuleMetrics.suppressed.fetch_add(1, std::memory_order_relaxed);
                 }
             } catch (const inja::InjaError& e) {
+                templateRuleMetrics.renderErrors.fetch_add(1, std::memory_order_relaxed);
+
                 VLOG(1) << "  Message template rendering failed: " << mappingTemplate << " : " << json.dump();
                 VLOG(1) << "    What: " << e.what();
                 VLOG(1) << "    INJA: " << e.type << ": " << e.message;
                 VLOG(1) << "    INJA (line:column):" << e.location.line << ":" << e.location.column;
             }
         } catch (const inja::InjaError& e) {
+            templateRuleMetrics.renderErrors.fetch_add(1, std::memory_order_relaxed);
+
             VLOG(1) << "  Topic template rendering failed: " << mappingTemplate << " : " << json.dump();
             VLOG(1) << "    What: " << e.what();
             VLOG(1) << "    INJA: " << e.type << ": " << e.message;
             VLOG(1) << "    INJA (line:column):" << e.location.line << ":" << e.location.column;
         }
+
+        recordLatency(templateRuleMetrics, ruleStart);
+    }
+
+    void MqttMapper::getDecodedMappings(const nlohmann::json& templateMapping,
+                                        const std::string& type,
+                                        const iot::mqtt::packets::Publish& publish,
+                                        MappedPublishes& mappedPublishes) {
+        VLOG(1) << "Topic mapping found for:";
+        VLOG(1) << "  Type: " << type;
+        VLOG(1) << "  Topic: " << publish.getTopic();
+        VLOG(1) << "  Message: "
+                << (type == "json" ? publish.getMessage() : "<binary, " + std::to_string(publish.getMessage().size()) + " bytes>");
+        VLOG(1) << "  QoS: " << static_cast<uint16_t>(publish.getQoS());
+        VLOG(1) << "  Retain: " << publish.getRetain();
+
+        try {
+            nlohmann::json json;
+
+            if (type == "cbor") {
+                json["message"] = nlohmann::json::from_cbor(publish.getMessage());
+            } else if (type == "msgpack") {
+                json["message"] = nlohmann::json::from_msgpack(publish.getMessage());
+            } else if (const auto jsonFieldExtractorIt = jsonFieldExtractors.find(&templateMapping);
+                       jsonFieldExtractorIt != jsonFieldExtractors.end()) {
+                json["message"] = jsonFieldExtractorIt->second.extract(publish.getMessage());
+            } else {
+                json["message"] = nlohmann::json::parse(publish.getMessage());
+            }
+
+            getTemplateMappings(templateMapping, json, publish, mappedPublishes);
+        } catch (const nlohmann::json::parse_error& e) {
+            countParseFailure(templateMapping);
+
+            VLOG(1) << "  Decoding " << type << " message into json failed";
+            VLOG(1) << "     What: " << e.what() << '\n'
+                    << "     Exception Id: " << e.id << '\n'
+                    << "     Byte position of error: " << e.byte;
+        }
+    }
+
+    void MqttMapper::getBinaryMappings(const nlohmann::json& binaryMapping,
+                                       const iot::mqtt::packets::Publish& publish,
+                                       MappedPublishes& mappedPublishes) {
+        VLOG(1) << "Topic mapping found for:";
+        VLOG(1) << "  Type: binary";
+        VLOG(1) << "  Topic: " << publish.getTopic();
+        VLOG(1) << "  Message: <binary, " << publish.getMessage().size() << " bytes>";
+        VLOG(1) << "  QoS: " << static_cast<uint16_t>(publish.getQoS());
+        VLOG(1) << "  Retain: " << publish.getRetain();
+
+        const std::map<const nlohmann::json*, BinaryLayout>::const_iterator binaryLayoutIt = binaryLayouts.find(&binaryMapping);
+
+        if (binaryLayoutIt != binaryLayouts.end()) {
+            nlohmann::json json;
+
+            if (binaryLayoutIt->second.decode(publish.getMessage(), json["message"])) {
+                getTemplateMappings(binaryMapping["mapping"], json, publish, mappedPublishes);
+            } else {
+                countParseFailure(binaryMapping["mapping"]);
+
+                VLOG(1) << "  Decoding binary message failed: " << publish.getMessage().size() << " bytes received, "
+                        << binaryLayoutIt->second.getSize() << " bytes expected";
+            }
+        }
     }
 
     void MqttMapper::getTemplateMappings(const nlohmann::json& templateMapping,
@@ -433,6 +709,9 @@ namespace mqtt::lib {
         try {
             VLOG(1) << "  Render data: " << json.dump();
 
+            std::vector<MappedPublish>& immediatePublishes = std::get<0>(mappedPublishes);
+            immediatePublishes.reserve(immediatePublishes.size() + (templateMapping.is_array() ? templateMapping.size() : 1));
+
             if (templateMapping.is_object()) {
                 getMappedTemplate(templateMapping, json, mappedPublishes);
             } else {
@@ -449,32 +728,144 @@ namespace mqtt::lib {
                                        const iot::mqtt::packets::Publish& publish,
                                        MappedPublishes& mappedPublishes) {
         if (staticMapping.is_object()) {
+            MappingMetrics::RuleMetrics& staticRuleMetrics = getRuleMetrics(staticMapping);
+            staticRuleMetrics.matches.fetch_add(1, std::memory_order_relaxed);
+            const std::chrono::steady_clock::time_point ruleStart = std::chrono::steady_clock::now();
+
+            const std::size_t publishCount = std::get<0>(mappedPublishes).size() + std::get<1>(mappedPublishes).size();
             getMappedMessage(staticMapping, publish, mappedPublishes);
+            staticRuleMetrics.emitted.fetch_add(std::get<0>(mappedPublishes).size() + std::get<1>(mappedPublishes).size() - publishCount,
+                                                std::memory_order_relaxed);
+
+            recordLatency(staticRuleMetrics, ruleStart);
         } else if (staticMapping.is_array()) {
             for (const nlohmann::json& concreteStaticMapping : staticMapping) {
-                getMappedMessage(concreteStaticMapping, publish, mappedPublishes);
+                getStaticMappings(concreteStaticMapping, publish, mappedPublishes);
             }
         }
     }
 
-    void MqttMapper::getMappedMessage(
-        const std::string& topic, const std::string& message, uint8_t qoS, bool retain, double delay, MappedPublishes& mappedPublishes) {
+    bool MqttMapper::getMappedMessage(const nlohmann::json& ruleJson,
+                                      const TopicInterner::InternedTopic& topic,
+                                      const std::string& message,
+                                      uint8_t qoS,
+                                      bool retain,
+                                      double delay,
+                                      const std::string& encoding,
+                                      MappedPublishes& mappedPublishes) {
         VLOG(1) << "  Mapped topic:";
-        VLOG(1) << "    -> " << topic;
+        VLOG(1) << "    -> " << topic.name;
         VLOG(1) << "  Mapped message:";
         VLOG(1) << "    -> " << message;
         VLOG(1) << "  Send mapping:" << (delay > 0 ? " delayed" : "");
-        VLOG(1) << "    Topic: " << topic;
+        VLOG(1) << "    Topic: " << topic.name;
         VLOG(1) << "    Message: " << message;
         VLOG(1) << "    QoS: " << static_cast<int>(qoS);
         VLOG(1) << "    retain: " << retain;
         VLOG(1) << "    Delay: " << delay;
-
-        if (delay < 0.0) {
-            std::get<0>(mappedPublishes).emplace_back(0, topic, message, qoS, false, retain);
+        VLOG(1) << "    Encoding: " << encoding;
+
+        std::string encodingBuffer;
+        const std::string& encodedMessage = encodeMessage(message, encoding, encodingBuffer);
+
+        bool emitted = true;
+
+        if (ruleJson.contains("rate_limit")) {
+            emitted = getRateLimitedMessage(ruleJson,
+                                            iot::mqtt::packets::Publish(0, std::string(topic.name), encodedMessage, qoS, false, retain),
+                                            topic.hash,
+                                            delay,
+                                            mappedPublishes);
+        } else if (delay < 0.0) {
+            std::get<0>(mappedPublishes)
+                .push_back({iot::mqtt::packets::Publish(0, std::string(topic.name), encodedMessage, qoS, false, retain), topic.hash});
         } else {
-            std::get<1>(mappedPublishes).push_back({delay, iot::mqtt::packets::Publish(0, topic, message, qoS, false, retain)});
+            std::get<1>(mappedPublishes)
+                .push_back(
+                    {delay,
+                     std::make_shared<const iot::mqtt::packets::Publish>(0, std::string(topic.name), encodedMessage, qoS, false, retain),
+                     topic.hash,
+                     nullptr});
         }
+
+        return emitted;
+    }
+
+    bool MqttMapper::getRateLimitedMessage(const nlohmann::json& ruleJson,
+                                           iot::mqtt::packets::Publish&& mappedPublish,
+                                           std::size_t topicHash,
+                                           double delay,
+                                           MappedPublishes& mappedPublishes) {
+        const nlohmann::json& rateLimitJson = ruleJson["rate_limit"];
+
+        MappingMetrics::RuleMetrics& limitedRuleMetrics = getRuleMetrics(ruleJson);
+        const void* rule = &limitedRuleMetrics != &unregisteredRuleMetrics ? static_cast<const void*>(&limitedRuleMetrics) : &ruleJson;
+
+        const RateLimiter::Decision decision = rateLimiter->admit(rule,
+                                                                  {rateLimitJson["rate"].get<double>(),
+                                                                   rateLimitJson["burst"].get<double>(),
+                                                                   rateLimitJson["scope"] == "topic",
+                                                                   rateLimitJson["mode"] == "coalesce"},
+                                                                  mappedPublish,
+                                                                  topicHash,
+                                                                  origin);
+
+        bool emitted = false;
+
+        switch (decision.admission) {
+            case RateLimiter::Admission::SEND:
+                if (delay < 0.0) {
+                    std::get<0>(mappedPublishes).push_back({std::move(mappedPublish), topicHash});
+                } else {
+                    std::get<1>(mappedPublishes)
+                        .push_back(
+                            {delay, std::make_shared<const iot::mqtt::packets::Publish>(std::move(mappedPublish)), topicHash, nullptr});
+                }
+
+                emitted = true;
+                break;
+            case RateLimiter::Admission::COALESCED:
+                VLOG(1) << "  Send mapping: rate limited, coalesced into the pending publish";
+
+                limitedRuleMetrics.coalesced.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case RateLimiter::Admission::DELAYED:
+                VLOG(1) << "  Send mapping: rate limited, delayed by " << decision.wait << "s";
+
+                std::get<1>(mappedPublishes)
+                    .push_back({std::max(delay, 0.0) + decision.wait, nullptr, topicHash, decision.coalescedPublish});
+
+                emitted = true;
+                break;
+            case RateLimiter::Admission::DROPPED:
+                VLOG(1) << "  Send mapping: rate limited, dropped";
+
+                limitedRuleMetrics.rateLimited.fetch_add(1, std::memory_order_relaxed);
+                break;
+        }
+
+        return emitted;
+    }
+
+    const std::string& MqttMapper::encodeMessage(const std::string& message, const std::string& encoding, std::string& encodedMessage) {
+        const std::string* result = &message;
+
+        if (encoding == "cbor" || encoding == "msgpack") {
+            // Rendered messages which are not valid JSON are encoded as plain JSON strings
+            nlohmann::json json = nlohmann::json::parse(message, nullptr, false);
+            if (json.is_discarded()) {
+                json = message;
+            }
+
+            if (encoding == "cbor") {
+                nlohmann::json::to_cbor(json, encodedMessage);
+            } else {
+                nlohmann::json::to_msgpack(json, encodedMessage);
+            }
+            result = &encodedMessage;
+        }
+
+        return *result;
     }
 
     void MqttMapper::getMappedMessage(const nlohmann::json& staticMapping,
@@ -486,11 +877,13 @@ namespace mqtt::lib {
 
         if (messageMapping.is_object()) {
             if (messageMapping["message"] == publish.getMessage()) {
-                getMappedMessage(staticMapping["mapped_topic"],
+                getMappedMessage(staticMapping,
+                                 topicInterner.intern(staticMapping["mapped_topic"].get_ref<const std::string&>()),
                                  messageMapping["mapped_message"],
                                  staticMapping["qos"],
                                  staticMapping["retain"],
                                  staticMapping["delay"],
+                                 staticMapping["encoding"],
                                  mappedPublishes);
             } else {
                 VLOG(1) << "    no matching mapped message found";
@@ -502,11 +895,13 @@ namespace mqtt::lib {
                 });
 
             if (matchedMessageMappingIterator != messageMapping.end()) {
-                getMappedMessage(staticMapping["mapped_topic"],
+                getMappedMessage(staticMapping,
+                                 topicInterner.intern(staticMapping["mapped_topic"].get_ref<const std::string&>()),
                                  (*matchedMessageMappingIterator)["mapped_message"],
                                  staticMapping["qos"],
                                  staticMapping["retain"],
                                  staticMapping["delay"],
+                                 staticMapping["encoding"],
                                  mappedPublishes);
             } else {
                 VLOG(1) << "    no matching mapped message found";
@@ -46,6 +46,12 @@ namespace iot::mqtt {
     class Topic;
 } // namespace iot::mqtt
 
+#include "BinaryLayout.h"
+#include "JsonFieldExtractor.h"
+#include "MappingMetrics.h"
+#include "RateLimiter.h"
+#include "TopicInterner.h"
+
 #include <iot/mqtt/packets/Publish.h>
 #include <utils/Timeval.h>
 
@@ -53,13 +59,21 @@ namespace iot::mqtt {
 
 namespace inja {
     class Environment;
-}
+    struct Template;
+} // namespace inja
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <list>
+#include <map>
+#include <memory>
 #include <nlohmann/json.hpp> // IWYU pragma: export
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 namespace nlohmann::json_schema {
@@ -73,14 +87,24 @@ namespace nlohmann::json_schema {
 
 namespace mqtt::lib {
 
+    class MappingWorkerPool;
+
     class MqttMapper {
     public:
+        struct MappedPublish {
+            iot::mqtt::packets::Publish publish;
+            std::size_t topicHash; // std::hash of the topic, computed once per distinct topic by the topic interner
+        };
+
         struct ScheduledPublish {
             utils::Timeval delay;
-            iot::mqtt::packets::Publish publish;
+            std::shared_ptr<const iot::mqtt::packets::Publish> publish; // shared and immutable while it waits in the delay queues
+            std::size_t topicHash;
+            std::shared_ptr<CoalescedPublish> coalescedPublish; // instead of publish if rate limited with "coalesce", taken when due
         };
 
-        using MappedPublishes = std::tuple<std::vector<iot::mqtt::packets::Publish>, std::vector<ScheduledPublish>>;
+        using MappedPublishes = std::tuple<std::vector<MappedPublish>, std::vector<ScheduledPublish>>;
+        using MappedCallback = std::function<void(MappedPublishes&&)>;
         using ConnectParameter = std::tuple<bool, std::string, std::string, uint8_t, bool, std::string, std::string>;
 
         MqttMapper();
@@ -100,7 +124,19 @@ namespace mqtt::lib {
         uint64_t getRevision() const;
 
         std::list<iot::mqtt::Topic> extractSubscriptions() const;
-        MappedPublishes getMappings(const iot::mqtt::packets::Publish& publish);
+        // origin identifies the source of publish (e.g. the broker client), coalesced rate limited publishes are never merged across
+        // origins
+        MappedPublishes getMappings(const iot::mqtt::packets::Publish& publish, const void* origin = nullptr);
+        void getMappings(const iot::mqtt::packets::Publish& publish,
+                         const MappedCallback& onMapped,
+                         const void* origin = nullptr); // on the event loop
+
+        void setWorkerThreads(std::size_t workerThreads); // 0: map synchronously inside getMappings
+        std::size_t getWorkerThreads() const;
+
+        const std::shared_ptr<MappingMetrics>& getMetrics() const;
+        void setMetrics(const std::shared_ptr<MappingMetrics>& mappingMetrics); // shared with the worker mappers
+        void setRateLimiter(const std::shared_ptr<RateLimiter>& rateLimiter);   // shared with the worker mappers
 
         static const nlohmann::json validate(const nlohmann::json& json);
         static const nlohmann::json validate(const nlohmann::json& json, nlohmann::json_schema::basic_error_handler& err);
@@ -111,27 +147,81 @@ namespace mqtt::lib {
         static void
         extractSubscriptions(const nlohmann::json& mappingJson, const std::string& topic, std::list<iot::mqtt::Topic>& topicList);
 
-        nlohmann::json findMatchingTopicLevel(const nlohmann::json& topicLevel, const std::string& topic);
+        void compileSubscriptions(const nlohmann::json& topicLevelJson, const std::string& topic);
+        void registerRuleMetrics(const nlohmann::json& ruleJson, const std::string& topic, const std::string& type);
+
+        MappingMetrics::RuleMetrics& getRuleMetrics(const nlohmann::json& ruleJson);
+        void recordLatency(MappingMetrics::RuleMetrics& ruleMetrics, std::chrono::steady_clock::time_point ruleStart) const;
+        void countParseFailure(const nlohmann::json& ruleJson);
+
+        static const nlohmann::json* findMatchingTopicLevel(const nlohmann::json& topicLevel, std::string_view topic);
+
+        const inja::Template& getParsedTemplate(const nlohmann::json& templateString); // can throw inja::InjaError
 
         void getMappedTemplate(const nlohmann::json& templateMapping, nlohmann::json& json, MappedPublishes& mappedPublishes);
+        void getDecodedMappings(const nlohmann::json& templateMapping,
+                                const std::string& type,
+                                const iot::mqtt::packets::Publish& publish,
+                                MappedPublishes& mappedPublishes);
+        void getBinaryMappings(const nlohmann::json& binaryMapping,
+                               const iot::mqtt::packets::Publish& publish,
+                               MappedPublishes& mappedPublishes);
         void getTemplateMappings(const nlohmann::json& templateMapping,
                                  nlohmann::json& json,
                                  const iot::mqtt::packets::Publish& publish,
                                  MappedPublishes& mappedPublishes);
-        static void getStaticMappings(const nlohmann::json& staticMapping,
-                                      const iot::mqtt::packets::Publish& publish,
-                                      MappedPublishes& mappedPublishes);
-
-        static void getMappedMessage(
-            const std::string& topic, const std::string& message, uint8_t qoS, bool retain, double delay, MappedPublishes& mappedPublishes);
-        static void
+        void getStaticMappings(const nlohmann::json& staticMapping,
+                               const iot::mqtt::packets::Publish& publish,
+                               MappedPublishes& mappedPublishes);
+
+        bool getMappedMessage(const nlohmann::json& ruleJson,
+                              const TopicInterner::InternedTopic& topic,
+                              const std::string& message,
+                              uint8_t qoS,
+                              bool retain,
+                              double delay,
+                              const std::string& encoding,
+                              MappedPublishes& mappedPublishes); // false if rate limited
+        void
         getMappedMessage(const nlohmann::json& staticMapping, const iot::mqtt::packets::Publish& publish, MappedPublishes& mappedPublishes);
+        bool getRateLimitedMessage(const nlohmann::json& ruleJson,
+                                   iot::mqtt::packets::Publish&& mappedPublish,
+                                   std::size_t topicHash,
+                                   double delay,
+                                   MappedPublishes& mappedPublishes);
+
+        // message itself without an encoding, else encodedMessage holding the cbor or msgpack encoding of message
+        static const std::string& encodeMessage(const std::string& message, const std::string& encoding, std::string& encodedMessage);
 
         nlohmann::json mappingJson;
         nlohmann::json mappingJsonUnpatched;
 
         std::list<void*> pluginHandles;
 
+        std::map<const nlohmann::json*, BinaryLayout> binaryLayouts;             // keyed by the "binary" section inside mappingJson
+        std::map<const nlohmann::json*, JsonFieldExtractor> jsonFieldExtractors; // keyed by the "json" section inside mappingJson
+
+        // Parsed on first use, as parsing binds the plugin callbacks registered in injaEnvironment
+        std::unordered_map<const nlohmann::json*, std::unique_ptr<inja::Template>> parsedTemplates; // keyed by the template string
+
+        // Buckets keyed by the metrics of the rule, which the owning mapper and its worker mappers have in common. Only the owner
+        // clears them on a mapping change.
+        std::shared_ptr<RateLimiter> rateLimiter;
+        bool ownsRateLimiter = true;
+        const void* origin = nullptr; // of the publish currently mapped
+
+        // Kept across mapping changes, as the output topics of successive revisions mostly stay the same
+        TopicInterner topicInterner;
+        std::string renderedTopic; // render target of the topic templates, reused to not allocate per render
+
+        std::shared_ptr<MappingMetrics> mappingMetrics;
+        std::unordered_map<const nlohmann::json*, MappingMetrics::RuleMetrics*> ruleMetrics; // keyed by the rule inside mappingJson
+        MappingMetrics::RuleMetrics unregisteredRuleMetrics{"", "", 0};
+        std::chrono::steady_clock::duration matchDuration{};
+
+        std::size_t workerThreads = 0;
+        std::unique_ptr<MappingWorkerPool> workerPool; // created on first use, after the process has been daemonized
+
         inja::Environment* injaEnvironment; // We need it as pointer as it must be removed befor unloading the plugin libraries
 
         static const nlohmann::json_schema::json_validator validator;
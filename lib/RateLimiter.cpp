@@ -0,0 +1,267 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "RateLimiter.h"
+
+#include <iot/mqtt/packets/Publish.h>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <optional>
+
+#endif
+
+namespace mqtt::lib {
+
+    namespace {
+
+        constexpr std::size_t MIN_SLOTS = 16;
+
+    } // namespace
+
+    class RateLimiter::Pending {
+    public:
+        Pending(iot::mqtt::packets::Publish&& publish, std::size_t topicHash, const void* origin)
+            : publish(std::move(publish))
+            , topicHash(topicHash)
+            , origin(origin) {
+        }
+
+        bool replace(iot::mqtt::packets::Publish& publish, std::size_t topicHash, const void* origin) {
+            const std::scoped_lock<std::mutex> pendingLock(mutex);
+
+            const bool replaced = !closed && origin == this->origin;
+            if (replaced) {
+                this->publish.emplace(std::move(publish));
+                this->topicHash = topicHash;
+            }
+
+            return replaced;
+        }
+
+        std::pair<std::shared_ptr<const iot::mqtt::packets::Publish>, std::size_t> take() {
+            const std::scoped_lock<std::mutex> pendingLock(mutex);
+
+            std::shared_ptr<const iot::mqtt::packets::Publish> takenPublish;
+            if (!closed) {
+                takenPublish = std::make_shared<const iot::mqtt::packets::Publish>(std::move(*publish));
+                publish.reset();
+                closed = true;
+            }
+
+            return {takenPublish, topicHash};
+        }
+
+        void close() {
+            const std::scoped_lock<std::mutex> pendingLock(mutex);
+
+            publish.reset();
+            closed = true;
+        }
+
+        bool isClosed() const {
+            const std::scoped_lock<std::mutex> pendingLock(mutex);
+
+            return closed;
+        }
+
+    private:
+        mutable std::mutex mutex; // the bucket side replaces on a mapping worker, the delay queue takes on the event loop
+
+        std::optional<iot::mqtt::packets::Publish> publish;
+        std::size_t topicHash;
+        const void* origin;
+        bool closed = false;
+    };
+
+    RateLimiter::Bucket::Bucket(double rate, double burst, Clock::time_point now)
+        : rate(rate)
+        , burst(burst)
+        , tokens(burst)
+        , refilled(now) {
+    }
+
+    void RateLimiter::Bucket::refill(Clock::time_point now) {
+        if (now > refilled) {
+            tokens = std::min(burst, tokens + std::chrono::duration<double>(now - refilled).count() * rate);
+            refilled = now;
+        }
+    }
+
+    bool RateLimiter::Bucket::take(Clock::time_point now) {
+        refill(now);
+
+        const bool taken = tokens >= 1.0;
+        if (taken) {
+            tokens -= 1.0;
+        }
+
+        return taken;
+    }
+
+    double RateLimiter::Bucket::reserve(Clock::time_point now) {
+        refill(now);
+
+        tokens -= 1.0;
+
+        return tokens < 0.0 ? -tokens / rate : 0.0;
+    }
+
+    bool RateLimiter::Bucket::isIdle(Clock::time_point now) const {
+        return (pending == nullptr || pending->isClosed()) &&
+               tokens + std::chrono::duration<double>(now - refilled).count() * rate >= burst;
+    }
+
+    RateLimiter::RateLimiter()
+        : slots(MIN_SLOTS) {
+    }
+
+    std::size_t RateLimiter::hashOf(const void* rule, std::size_t topicHash) {
+        return topicHash ^ (std::hash<const void*>{}(rule) * 0x9e3779b97f4a7c15ULL);
+    }
+
+    RateLimiter::Bucket& RateLimiter::getBucket(
+        const void* rule, std::string_view topic, std::size_t topicHash, double rate, double burst, Clock::time_point now) {
+        const std::size_t hash = hashOf(rule, topicHash);
+
+        std::size_t index = hash & (slots.size() - 1);
+        for (; slots[index].used; index = (index + 1) & (slots.size() - 1)) {
+            if (slots[index].hash == hash && slots[index].rule == rule && slots[index].topic == topic) {
+                return slots[index].bucket;
+            }
+        }
+
+        if ((used + 1) * 4 > slots.size() * 3) {
+            rebuild(now);
+
+            for (index = hash & (slots.size() - 1); slots[index].used; index = (index + 1) & (slots.size() - 1)) {
+            }
+        }
+
+        Slot& slot = slots[index];
+        slot.used = true;
+        slot.hash = hash;
+        slot.rule = rule;
+        slot.topic = topic;
+        slot.bucket = Bucket(rate, burst, now);
+        ++used;
+
+        return slot.bucket;
+    }
+
+    RateLimiter::Decision RateLimiter::admit(
+        const void* rule, const Limit& limit, iot::mqtt::packets::Publish& publish, std::size_t topicHash, const void* origin) {
+        const Clock::time_point now = Clock::now();
+
+        const std::scoped_lock<std::mutex> rateLimiterLock(mutex);
+
+        Bucket& bucket = getBucket(rule,
+                                   limit.perTopic ? std::string_view(publish.getTopic()) : std::string_view(),
+                                   limit.perTopic ? topicHash : 0,
+                                   limit.rate,
+                                   limit.burst,
+                                   now);
+
+        Decision decision{Admission::DROPPED, 0, nullptr};
+
+        if (bucket.take(now)) {
+            decision.admission = Admission::SEND;
+        } else if (limit.coalesce) {
+            if (bucket.pending != nullptr && bucket.pending->replace(publish, topicHash, origin)) {
+                decision.admission = Admission::COALESCED;
+            } else {
+                decision.admission = Admission::DELAYED;
+                decision.wait = bucket.reserve(now);
+
+                bucket.pending = std::make_shared<Pending>(std::move(publish), topicHash, origin);
+                decision.coalescedPublish = std::make_shared<CoalescedPublish>(bucket.pending);
+            }
+        }
+
+        return decision;
+    }
+
+    void RateLimiter::rebuild(Clock::time_point now) {
+        std::vector<Slot> oldSlots = std::move(slots);
+
+        const std::size_t live = static_cast<std::size_t>(std::count_if(oldSlots.begin(), oldSlots.end(), [now](const Slot& slot) {
+            return slot.used && !slot.bucket.isIdle(now);
+        }));
+
+        slots = std::vector<Slot>(std::max(MIN_SLOTS, std::bit_ceil((live + 1) * 2)));
+        used = 0;
+
+        for (Slot& oldSlot : oldSlots) {
+            if (oldSlot.used && !oldSlot.bucket.isIdle(now)) {
+                std::size_t index = oldSlot.hash & (slots.size() - 1);
+                while (slots[index].used) {
+                    index = (index + 1) & (slots.size() - 1);
+                }
+
+                slots[index] = std::move(oldSlot);
+                ++used;
+            }
+        }
+    }
+
+    void RateLimiter::clear() {
+        const std::scoped_lock<std::mutex> rateLimiterLock(mutex);
+
+        slots = std::vector<Slot>(MIN_SLOTS);
+        used = 0;
+    }
+
+    CoalescedPublish::CoalescedPublish(std::shared_ptr<RateLimiter::Pending> pending)
+        : pending(std::move(pending)) {
+    }
+
+    CoalescedPublish::~CoalescedPublish() {
+        pending->close();
+    }
+
+    std::pair<std::shared_ptr<const iot::mqtt::packets::Publish>, std::size_t> CoalescedPublish::take() {
+        return pending->take();
+    }
+
+} // namespace mqtt::lib
@@ -0,0 +1,165 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTBROKER_LIB_RATELIMITER_H
+#define MQTTBROKER_LIB_RATELIMITER_H
+
+namespace iot::mqtt::packets {
+    class Publish;
+} // namespace iot::mqtt::packets
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+namespace mqtt::lib {
+
+    class CoalescedPublish;
+
+    // Token buckets of the "rate_limit" sections of a mapping, keyed by the rule and, for per-topic limits, the rendered topic.
+    // Buckets live in an open-addressing table with linear probing. Before the table grows, buckets which are idle (refilled to
+    // their burst and without a pending coalesced publish) are evicted, so one-shot topics do not accumulate.
+    // One limiter is shared by a mapper and all its worker mappers, thus admit() is serialized by a mutex.
+    class RateLimiter {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        enum class Admission { SEND, COALESCED, DELAYED, DROPPED };
+
+        struct Limit {
+            double rate;
+            double burst;
+            bool perTopic;
+            bool coalesce;
+        };
+
+        struct Decision {
+            Admission admission;
+            double wait = 0;                                    // DELAYED: seconds until the reserved token is due
+            std::shared_ptr<CoalescedPublish> coalescedPublish; // DELAYED: to be queued for wait seconds
+        };
+
+        class Pending; // the latest value of a coalescing bucket, shared by the bucket and the CoalescedPublish
+
+        RateLimiter();
+
+        // Takes a token for publish. Without a token, publish is dropped or, for coalescing limits, moved into the pending publish
+        // of the bucket if that is still waiting and stems from the same origin (e.g. the same broker client). Otherwise the next
+        // token is reserved and publish becomes the new pending publish, returned for the delay queue of the caller.
+        Decision admit(
+            const void* rule, const Limit& limit, iot::mqtt::packets::Publish& publish, std::size_t topicHash, const void* origin);
+
+        void clear();
+
+    private:
+        class Bucket {
+        public:
+            Bucket() = default;
+            Bucket(double rate, double burst, Clock::time_point now);
+
+            bool take(Clock::time_point now);      // false if no token is available
+            double reserve(Clock::time_point now); // takes the next token in advance, returns the seconds until it is due
+
+            bool isIdle(Clock::time_point now) const;
+
+            std::shared_ptr<Pending> pending;
+
+        private:
+            void refill(Clock::time_point now);
+
+            double rate = 0;
+            double burst = 0;
+            double tokens = 0;
+            Clock::time_point refilled;
+        };
+
+        struct Slot {
+            bool used = false;
+            std::size_t hash = 0;
+            const void* rule = nullptr;
+            std::string topic;
+            Bucket bucket;
+        };
+
+        static std::size_t hashOf(const void* rule, std::size_t topicHash);
+
+        // Returns the bucket of rule (and topic, if not empty), creating it full if it does not exist. References stay valid until
+        // the next call.
+        Bucket&
+        getBucket(const void* rule, std::string_view topic, std::size_t topicHash, double rate, double burst, Clock::time_point now);
+
+        void rebuild(Clock::time_point now); // evicts idle buckets and resizes to a load factor of at most 1/2
+
+        std::mutex mutex;
+        std::vector<Slot> slots;
+        std::size_t used = 0;
+    };
+
+    // A coalesced publish as it waits in a delay queue. The value is only materialized as an immutable publish by take() once it
+    // is due, which also ends coalescing into it. Destroying it untaken (the delay queue went away) ends coalescing as well.
+    class CoalescedPublish {
+    public:
+        explicit CoalescedPublish(std::shared_ptr<RateLimiter::Pending> pending);
+        CoalescedPublish(const CoalescedPublish&) = delete;
+        CoalescedPublish& operator=(const CoalescedPublish&) = delete;
+
+        ~CoalescedPublish();
+
+        // The latest value and the hash of its topic, which may differ from the first one for limits with scope "rule".
+        // nullptr if already taken.
+        std::pair<std::shared_ptr<const iot::mqtt::packets::Publish>, std::size_t> take();
+
+    private:
+        std::shared_ptr<RateLimiter::Pending> pending;
+    };
+
+} // namespace mqtt::lib
+
+#endif // MQTTBROKER_LIB_RATELIMITER_H
@@ -0,0 +1,86 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTBROKER_LIB_TOPICINTERNER_H
+#define MQTTBROKER_LIB_TOPICINTERNER_H
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+namespace mqtt::lib {
+
+    // Rendered output topics of a mapping come from a small set of distinct values. Each of them is stored once together with its
+    // hash, which is handed on with the mapped publish and used for shard and rate-limit bucketing, so that it is computed once per
+    // topic instead of once per publish. The mapped publish itself still carries its own copy of the topic. The table is bounded:
+    // once maxTopics topics are stored, further ones are passed through without being stored.
+    class TopicInterner {
+    public:
+        struct InternedTopic {
+            std::string_view name; // stable for the lifetime of the interner, unless the table was full
+            std::size_t hash;      // equal to std::hash<std::string> of the topic
+        };
+
+        explicit TopicInterner(std::size_t maxTopics);
+
+        InternedTopic intern(std::string_view topic); // if the table is full, name refers to topic
+
+    private:
+        struct Entry {
+            std::string name;
+            InternedTopic internedTopic;
+        };
+
+        std::deque<Entry> entries; // never moves its elements, so the views into the names stay valid
+        std::unordered_map<std::string_view, const InternedTopic*> index;
+
+        std::size_t maxTopics;
+    };
+
+} // namespace mqtt::lib
+
+#endif // MQTTBROKER_LIB_TOPICINTERNER_H
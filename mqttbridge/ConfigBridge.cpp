@@ -52,7 +52,25 @@ namespace mqtt::bridge {
         , bridgeDefinitionOpt( //
               addOption("--definition", "MQTT bridge definition file (JSON format)", "file", CLI::ExistingFile))
         , htmlDirOpt( //
-              addOption("--html-dir", "Path to html source directory", "directory", CLI::ExistingDirectory)) {
+              addOption("--html-dir", "Path to html source directory", "directory", CLI::ExistingDirectory))
+        , eventReceiverBudgetOpt( //
+              addOption("--event-receiver-budget",
+                        "Bytes of server sent events a browser connection may have queued but not yet sent (0 = unlimited)",
+                        "bytes",
+                        "1048576",
+                        CLI::NonNegativeNumber))
+        , eventReceiverOverflowOpt( //
+              addOption("--event-receiver-overflow",
+                        "What to do with a browser connection exceeding its budget",
+                        "policy",
+                        "snapshot",
+                        CLI::IsMember({"snapshot", "disconnect"})))
+        , loopReportOpt( //
+              addFlag("--loop-report{true}",
+                      "Publish the event loop statistics to $SYS/mqttsuite/bridge/loop every 10 s",
+                      "bool",
+                      "true",
+                      CLI::IsMember({"true", "false"}))) {
         required(bridgeDefinitionOpt);
     }
 
@@ -75,4 +93,28 @@ namespace mqtt::bridge {
         return htmlDirOpt->as<std::string>();
     }
 
+    void ConfigBridge::setEventReceiverBudget(std::size_t eventReceiverBudget) {
+        setDefaultValue(eventReceiverBudgetOpt, eventReceiverBudget);
+    }
+
+    std::size_t ConfigBridge::getEventReceiverBudget() const {
+        return eventReceiverBudgetOpt->as<std::size_t>();
+    }
+
+    void ConfigBridge::setEventReceiverOverflow(const std::string& eventReceiverOverflow) {
+        setDefaultValue(eventReceiverOverflowOpt, eventReceiverOverflow);
+    }
+
+    std::string ConfigBridge::getEventReceiverOverflow() const {
+        return eventReceiverOverflowOpt->as<std::string>();
+    }
+
+    void ConfigBridge::setLoopReport(bool loopReport) {
+        setDefaultValue(loopReportOpt, loopReport);
+    }
+
+    bool ConfigBridge::getLoopReport() const {
+        return loopReportOpt->as<bool>();
+    }
+
 } // namespace mqtt::bridge
@@ -46,6 +46,7 @@
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
+#include <cstddef>
 #include <string>
 #include <string_view>
 
@@ -68,9 +69,21 @@ namespace mqtt::bridge {
         void setHtmlDir(const std::string& htmlDir) const;
         std::string getHtmlDir() const;
 
+        void setEventReceiverBudget(std::size_t eventReceiverBudget);
+        std::size_t getEventReceiverBudget() const;
+
+        void setEventReceiverOverflow(const std::string& eventReceiverOverflow);
+        std::string getEventReceiverOverflow() const;
+
+        void setLoopReport(bool loopReport);
+        bool getLoopReport() const;
+
     private:
         CLI::Option* bridgeDefinitionOpt;
         CLI::Option* htmlDirOpt;
+        CLI::Option* eventReceiverBudgetOpt;
+        CLI::Option* eventReceiverOverflowOpt;
+        CLI::Option* loopReportOpt;
     };
 
 } // namespace mqtt::bridge
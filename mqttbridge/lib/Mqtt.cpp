@@ -42,6 +42,7 @@
 #include "Mqtt.h"
 
 #include "lib/BridgeStore.h"
+#include "lib/LoopMonitor.h"
 
 #include <iot/mqtt/packets/Connack.h>
 
@@ -94,6 +95,7 @@ namespace mqtt::bridge::lib {
 
     void Mqtt::onDisconnected() {
         mqtt::bridge::lib::BridgeStore::instance().mqttDisconnected(broker, this);
+        mqtt::lib::LoopMonitor::instance().removeReporter(this);
 
         VLOG(1) << "MQTT: Disconnected";
     }
@@ -110,12 +112,18 @@ namespace mqtt::bridge::lib {
     void Mqtt::onConnack(const iot::mqtt::packets::Connack& connack) {
         if (connack.getReturnCode() == 0) {
             mqtt::bridge::lib::BridgeStore::instance().mqttConnected(broker, this);
+            mqtt::lib::LoopMonitor::instance().addReporter(this, [this](const std::string& topic, const std::string& message) {
+                sendPublish(topic, message, 0, false);
+            });
 
             sendSubscribe(broker.getTopics());
         }
     }
 
     void Mqtt::onPublish(const iot::mqtt::packets::Publish& publish) {
+        static mqtt::lib::LatencyHistogram& onPublishTime = mqtt::lib::LoopMonitor::instance().getSection("onPublish");
+        const mqtt::lib::LoopMonitor::Timing timing(onPublishTime);
+
         broker.getBridge().publish(this, publish);
     }
 
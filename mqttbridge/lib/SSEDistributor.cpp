@@ -41,6 +41,7 @@
 
 #include "SSEDistributor.h"
 
+#include <core/socket/stream/SocketConnection.h>
 #include <express/Response.h>
 #include <web/http/server/SocketContext.h>
 
@@ -50,17 +51,26 @@ struct tm;
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
+#include <algorithm>
 #include <ctime>
 #include <functional>
 #include <iomanip>
 #include <log/Logger.h>
 #include <nlohmann/json.hpp>
 #include <sstream>
+#include <vector>
 
 #endif // DOXYGEN_SHOULD_SKIP_THIS
 
 namespace mqtt::bridge::lib {
 
+    // Bytes written to the response but not yet handed to the kernel
+    static std::size_t backlogOf(const std::shared_ptr<express::Response>& response) {
+        const core::socket::stream::SocketConnection* socketConnection = response->getSocketContext()->getSocketConnection();
+
+        return socketConnection->getTotalQueued() - socketConnection->getTotalSent();
+    }
+
     SSEDistributor::SSEDistributor()
         : onlineSinceTimePoint(std::chrono::system_clock::now()) {
     }
@@ -75,7 +85,7 @@ namespace mqtt::bridge::lib {
                                           [[maybe_unused]] const std::string& lastEventId) {
         const std::uint64_t eventReceiverId = nextEventReceiverId++;
 
-        eventReceiverList.emplace_back(eventReceiverId, response);
+        EventReceiver& eventReceiver = eventReceiverList.emplace_back(eventReceiverId, response);
 
         response->getSocketContext()->onDisconnected([this, eventReceiverId]() {
             eventReceiverList.remove_if([eventReceiverId](const EventReceiver& eventReceiver) {
@@ -83,11 +93,46 @@ namespace mqtt::bridge::lib {
             });
         });
 
-        for (const auto& event : replayEvents) {
-            sendEvent(response, event.getData(), event.getEvent(), event.getId());
+        sendSnapshot(eventReceiver);
+    }
+
+    void SSEDistributor::sendSnapshot(EventReceiver& eventReceiver) {
+        if (const std::shared_ptr<express::Response> response = eventReceiver.getResponse()) {
+            // Only what changed since the last event the receiver got: a recovering receiver gets no duplicates
+            for (const auto& replayEvent : replayEvents) {
+                if (replayEvent.getSeq() >= eventReceiver.getDeliveredUpTo()) {
+                    sendEvent(response, replayEvent.getData(), replayEvent.getEvent(), replayEvent.getId());
+                }
+            }
+
+            eventReceiver.snapshotSent(nextEventSeq);
         }
     }
 
+    void SSEDistributor::setEventReceiverBudget(std::size_t eventReceiverBudget, OverflowPolicy overflowPolicy) {
+        this->eventReceiverBudget = eventReceiverBudget;
+        this->overflowPolicy = overflowPolicy;
+    }
+
+    SSEDistributor::OverflowPolicy SSEDistributor::parseOverflowPolicy(const std::string& overflowPolicy) {
+        return overflowPolicy == "disconnect" ? OverflowPolicy::DISCONNECT : OverflowPolicy::SNAPSHOT;
+    }
+
+    nlohmann::json SSEDistributor::getEventReceiverMetrics() const {
+        std::size_t snapshotPending = 0;
+        for (const EventReceiver& eventReceiver : eventReceiverList) {
+            snapshotPending += eventReceiver.isSnapshotRequired() ? 1 : 0;
+        }
+
+        return {{"receivers", eventReceiverList.size()},
+                {"budget", eventReceiverBudget},
+                {"overflow_policy", overflowPolicy == OverflowPolicy::DISCONNECT ? "disconnect" : "snapshot"},
+                {"snapshot_pending", snapshotPending},
+                {"snapshots_required", snapshotsRequired},
+                {"receivers_disconnected", receiversDisconnected},
+                {"events_dropped", eventsDropped}};
+    }
+
     void SSEDistributor::sendEvent(const std::shared_ptr<express::Response>& response,
                                    const std::string& data,
                                    const std::string& event,
@@ -111,91 +156,146 @@ namespace mqtt::bridge::lib {
         sendEvent(response, json.dump(), event, id);
     }
 
-    void SSEDistributor::sendEvent(const std::string& data, const std::string& event, const std::string& id) {
+    void SSEDistributor::sendEvent(const std::string& data, const std::string& key, const std::string& event, const std::string& id) {
         VLOG(0) << "Server sent event: " << event << "\n" << data;
 
-        for (const auto& eventReceiver : eventReceiverList) {
+        const std::uint64_t seq = nextEventSeq++;
+
+        const std::size_t eventSize = data.size() + event.size() + id.size() + 20; // with field names and line breaks
+        std::vector<std::shared_ptr<express::Response>> overBudget;
+
+        for (auto& eventReceiver : eventReceiverList) {
             if (const auto& response = eventReceiver.getResponse()) {
-                sendEvent(response, data, event, id);
+                if (eventReceiver.isSnapshotRequired()) {
+                    ++eventsDropped;
+                } else if (eventReceiverBudget > 0 && response->isConnected() &&
+                           eventReceiver.getBacklog() + eventSize > eventReceiverBudget) {
+                    ++eventsDropped;
+
+                    if (overflowPolicy == OverflowPolicy::DISCONNECT) {
+                        overBudget.push_back(response);
+                    } else {
+                        VLOG(1) << "Server sent events: Receiver "
+                                << response->getSocketContext()->getSocketConnection()->getConnectionName()
+                                << " over budget, dropping events until it drained";
+
+                        ++snapshotsRequired;
+                        eventReceiver.requireSnapshot(eventReceiverBudget / 4, [this](EventReceiver& eventReceiver) {
+                            sendSnapshot(eventReceiver);
+                        });
+                    }
+                } else {
+                    sendEvent(response, data, event, id);
+                    eventReceiver.delivered(seq);
+                }
             }
         }
 
-        replayEvents.emplace_back(data, event, id);
+        // Closing may remove receivers from eventReceiverList, thus not while iterating it
+        for (const auto& response : overBudget) {
+            LOG(WARNING) << "Server sent events: Receiver " << response->getSocketContext()->getSocketConnection()->getConnectionName()
+                         << " over budget, disconnecting";
+
+            ++receiversDisconnected;
+            response->getSocketContext()->getSocketConnection()->close();
+        }
+
+        // Bounded by the number of bridges and brokers: an event supersedes the previous one of its key
+        replayEvents.remove_if([&key](const Event& replayEvent) {
+            return replayEvent.getKey() == key;
+        });
+        replayEvents.emplace_back(seq, key, data, event, id);
     }
 
-    void SSEDistributor::sendJsonEvent(const nlohmann::json& json, const std::string& event, const std::string& id) {
-        sendEvent(json.dump(), event, id);
+    void
+    SSEDistributor::sendJsonEvent(const nlohmann::json& json, const std::string& key, const std::string& event, const std::string& id) {
+        sendEvent(json.dump(), key, event, id);
     }
 
     void SSEDistributor::bridgesStarting() {
         replayEvents.clear();
 
-        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}}, "bridges_starting", std::to_string(id++));
+        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}}, "bridges", "bridges_starting", std::to_string(id++));
     }
 
     void SSEDistributor::bridgesStarted() {
-        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}}, "bridges_started", std::to_string(id++));
+        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}}, "bridges", "bridges_started", std::to_string(id++));
     }
 
     void SSEDistributor::bridgesStopping() {
-        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}}, "bridges_stopping", std::to_string(id++));
+        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}}, "bridges", "bridges_stopping", std::to_string(id++));
     }
 
     void SSEDistributor::bridgesStopped() {
-        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}}, "bridges_stopped", std::to_string(id++));
+        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}}, "bridges", "bridges_stopped", std::to_string(id++));
     }
 
     void SSEDistributor::bridgeDisabled(const std::string& bridgeName) {
-        sendJsonEvent(
-            {{"at", timePointToString(std::chrono::system_clock::now())}, {"name", bridgeName}}, "bridge_disabled", std::to_string(id++));
+        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}, {"name", bridgeName}},
+                      "bridge/" + bridgeName,
+                      "bridge_disabled",
+                      std::to_string(id++));
     }
 
     void SSEDistributor::bridgeStarting(const std::string& bridgeName) {
-        sendJsonEvent(
-            {{"at", timePointToString(std::chrono::system_clock::now())}, {"name", bridgeName}}, "bridge_starting", std::to_string(id++));
+        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}, {"name", bridgeName}},
+                      "bridge/" + bridgeName,
+                      "bridge_starting",
+                      std::to_string(id++));
     }
 
     void SSEDistributor::bridgeStarted(const std::string& bridgeName) {
-        sendJsonEvent(
-            {{"at", timePointToString(std::chrono::system_clock::now())}, {"name", bridgeName}}, "bridge_started", std::to_string(id++));
+        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}, {"name", bridgeName}},
+                      "bridge/" + bridgeName,
+                      "bridge_started",
+                      std::to_string(id++));
     }
 
     void SSEDistributor::bridgeStopping(const std::string& bridgeName) {
-        sendJsonEvent(
-            {{"at", timePointToString(std::chrono::system_clock::now())}, {"name", bridgeName}}, "bridge_stopping", std::to_string(id++));
+        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}, {"name", bridgeName}},
+                      "bridge/" + bridgeName,
+                      "bridge_stopping",
+                      std::to_string(id++));
     }
 
     void SSEDistributor::bridgeStopped(const std::string& bridgeName) {
-        sendJsonEvent(
-            {{"at", timePointToString(std::chrono::system_clock::now())}, {"name", bridgeName}}, "bridge_stopped", std::to_string(id++));
+        sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}, {"name", bridgeName}},
+                      "bridge/" + bridgeName,
+                      "bridge_stopped",
+                      std::to_string(id++));
     }
 
     void SSEDistributor::brokerDisabled(const std::string& bridgeName, const std::string& instanceName) {
         sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}, {"bridge", bridgeName}, {"instance", instanceName}},
+                      "broker/" + bridgeName + "/" + instanceName,
                       "broker_disabled",
                       std::to_string(id++));
     }
 
     void SSEDistributor::brokerConnecting(const std::string& bridgeName, const std::string& instanceName) {
         sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}, {"bridge", bridgeName}, {"instance", instanceName}},
+                      "broker/" + bridgeName + "/" + instanceName,
                       "broker_connecting",
                       std::to_string(id++));
     }
 
     void SSEDistributor::brokerConnected(const std::string& bridgeName, const std::string& instanceName) {
         sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}, {"bridge", bridgeName}, {"instance", instanceName}},
+                      "broker/" + bridgeName + "/" + instanceName,
                       "broker_connected",
                       std::to_string(id++));
     }
 
     void SSEDistributor::brokerDisconnecting(const std::string& bridgeName, const std::string& instanceName) {
         sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}, {"bridge", bridgeName}, {"instance", instanceName}},
+                      "broker/" + bridgeName + "/" + instanceName,
                       "broker_disconnecting",
                       std::to_string(id++));
     }
 
     void SSEDistributor::brokerDisconnected(const std::string& bridgeName, const std::string& instanceName) {
         sendJsonEvent({{"at", timePointToString(std::chrono::system_clock::now())}, {"bridge", bridgeName}, {"instance", instanceName}},
+                      "broker/" + bridgeName + "/" + instanceName,
                       "broker_disconnected",
                       std::to_string(id++));
     }
@@ -257,18 +357,79 @@ namespace mqtt::bridge::lib {
 
     SSEDistributor::EventReceiver::~EventReceiver() {
         heartbeatTimer.cancel();
+        drainTimer.cancel();
     }
 
     std::shared_ptr<express::Response> SSEDistributor::EventReceiver::getResponse() const {
         return response.lock();
     }
 
-    SSEDistributor::Event::Event(const std::string& data, const std::string& event, const std::string& id)
-        : data(data)
+    bool SSEDistributor::EventReceiver::isSnapshotRequired() const {
+        return snapshotRequired;
+    }
+
+    void SSEDistributor::EventReceiver::requireSnapshot(std::size_t lowWatermark, const std::function<void(EventReceiver&)>& onDrained) {
+        snapshotRequired = true;
+
+        drainTimer = core::timer::Timer::intervalTimer(
+            [this, lowWatermark, onDrained]() {
+                const std::shared_ptr<express::Response> response = getResponse();
+
+                if (!response || !response->isConnected()) {
+                    drainTimer.cancel();
+                } else if (backlogOf(response) <= lowWatermark) {
+                    drainTimer.cancel();
+                    snapshotRequired = false;
+
+                    onDrained(*this);
+                }
+            },
+            0.5);
+    }
+
+    std::size_t SSEDistributor::EventReceiver::getBacklog() {
+        std::size_t backlog = 0;
+
+        if (const std::shared_ptr<express::Response> response = getResponse()) {
+            backlog = backlogOf(response);
+
+            // Everything queued before the snapshot has been sent once the backlog fell below the snapshot backlog
+            snapshotBacklog = std::min(snapshotBacklog, backlog);
+            backlog -= snapshotBacklog;
+        }
+
+        return backlog;
+    }
+
+    void SSEDistributor::EventReceiver::delivered(std::uint64_t seq) {
+        deliveredUpTo = seq + 1;
+    }
+
+    void SSEDistributor::EventReceiver::snapshotSent(std::uint64_t nextSeq) {
+        deliveredUpTo = nextSeq;
+
+        if (const std::shared_ptr<express::Response> response = getResponse()) {
+            snapshotBacklog = backlogOf(response);
+        }
+    }
+
+    SSEDistributor::Event::Event(
+        std::uint64_t seq, const std::string& key, const std::string& data, const std::string& event, const std::string& id)
+        : seq(seq)
+        , key(key)
+        , data(data)
         , event(event)
         , id(id) {
     }
 
+    std::uint64_t SSEDistributor::Event::getSeq() const {
+        return seq;
+    }
+
+    const std::string& SSEDistributor::Event::getKey() const {
+        return key;
+    }
+
     const std::string& SSEDistributor::Event::getData() const {
         return data;
     }
@@ -50,7 +50,9 @@ namespace express {
 
 #include <chrono>
 #include <core/timer/Timer.h>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <memory>
 #include <nlohmann/json_fwd.hpp>
@@ -74,16 +76,36 @@ namespace mqtt::bridge::lib {
                 return id;
             }
 
+            bool isSnapshotRequired() const;
+            void requireSnapshot(std::size_t lowWatermark, const std::function<void(EventReceiver&)>& onDrained);
+
+            // Backlog queued after the last snapshot. The snapshot itself is not held against the budget.
+            std::size_t getBacklog();
+
+            void delivered(std::uint64_t seq);
+            void snapshotSent(std::uint64_t nextSeq);
+
+            std::uint64_t getDeliveredUpTo() const {
+                return deliveredUpTo;
+            }
+
         private:
             std::uint64_t id;
             std::weak_ptr<express::Response> response;
 
             core::timer::Timer heartbeatTimer;
+
+            // Set while the receiver is over its byte budget: events are dropped until it drains and gets the replay again
+            bool snapshotRequired = false;
+            core::timer::Timer drainTimer;
+
+            std::size_t snapshotBacklog = 0;
+            std::uint64_t deliveredUpTo = 0; // events with a lower seq have been sent to the receiver
         };
 
         class Event {
         public:
-            Event(const std::string& data, const std::string& event, const std::string& id);
+            Event(std::uint64_t seq, const std::string& key, const std::string& data, const std::string& event, const std::string& id);
 
             Event(const Event&) = delete;
             Event(Event&&) = delete;
@@ -91,11 +113,15 @@ namespace mqtt::bridge::lib {
             Event& operator=(const Event&) = delete;
             Event& operator=(Event&&) = delete;
 
+            std::uint64_t getSeq() const;
+            const std::string& getKey() const;
             const std::string& getData() const;
             const std::string& getEvent() const;
             const std::string& getId() const;
 
         private:
+            std::uint64_t seq;
+            std::string key;
             std::string data;
             std::string event;
             std::string id;
@@ -104,6 +130,8 @@ namespace mqtt::bridge::lib {
         SSEDistributor();
 
     public:
+        enum class OverflowPolicy { SNAPSHOT, DISCONNECT };
+
         static SSEDistributor& instance();
 
         SSEDistributor(const SSEDistributor&) = delete;
@@ -116,6 +144,12 @@ namespace mqtt::bridge::lib {
 
         void addEventReceiver(const std::shared_ptr<express::Response>& response, const std::string& lastEventId);
 
+        void setEventReceiverBudget(std::size_t eventReceiverBudget, OverflowPolicy overflowPolicy); // in bytes, 0 = unlimited
+
+        static OverflowPolicy parseOverflowPolicy(const std::string& overflowPolicy);
+
+        nlohmann::json getEventReceiverMetrics() const;
+
         void bridgesStarting();
         void bridgesStarted();
 
@@ -146,8 +180,11 @@ namespace mqtt::bridge::lib {
                                    const nlohmann::json& json,
                                    const std::string& event = "",
                                    const std::string& id = "");
-        void sendEvent(const std::string& data, const std::string& event = "", const std::string& id = "");
-        void sendJsonEvent(const nlohmann::json& json, const std::string& event = "", const std::string& id = "");
+        // key: the bridge or broker whose state the event reports, only its latest event is replayed
+        void sendEvent(const std::string& data, const std::string& key, const std::string& event, const std::string& id);
+        void sendJsonEvent(const nlohmann::json& json, const std::string& key, const std::string& event, const std::string& id);
+
+        void sendSnapshot(EventReceiver& eventReceiver);
 
         static std::string timePointToString(const std::chrono::time_point<std::chrono::system_clock>& timePoint);
         static std::string
@@ -162,7 +199,14 @@ namespace mqtt::bridge::lib {
         uint64_t id = 0;
         std::uint64_t nextEventReceiverId = 0;
 
-        std::list<Event> replayEvents;
+        std::list<Event> replayEvents; // the latest event per key, in the order they were sent
+        std::uint64_t nextEventSeq = 0;
+
+        std::size_t eventReceiverBudget = 0;
+        OverflowPolicy overflowPolicy = OverflowPolicy::SNAPSHOT;
+        std::uint64_t eventsDropped = 0;
+        std::uint64_t snapshotsRequired = 0;
+        std::uint64_t receiversDisconnected = 0;
     };
 
 } // namespace mqtt::bridge::lib
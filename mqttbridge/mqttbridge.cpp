@@ -43,6 +43,7 @@
 #include "SocketContextFactory.h"
 #include "config.h"
 #include "lib/BridgeStore.h"
+#include "lib/LoopMonitor.h"
 #include "lib/Mqtt.h"
 #include "lib/SSEDistributor.h"
 
@@ -562,8 +563,24 @@ int main(int argc, char* argv[]) {
 
     core::SNodeC::init(argc, argv);
 
+    mqtt::lib::LoopMonitor::instance().start("bridge",
+                                             utils::Config::configRoot.getSubCommand<mqtt::bridge::ConfigBridge>()->getLoopReport());
+
+    mqtt::bridge::lib::SSEDistributor::instance().setEventReceiverBudget(
+        utils::Config::configRoot.getSubCommand<mqtt::bridge::ConfigBridge>()->getEventReceiverBudget(),
+        mqtt::bridge::lib::SSEDistributor::parseOverflowPolicy(
+            utils::Config::configRoot.getSubCommand<mqtt::bridge::ConfigBridge>()->getEventReceiverOverflow()));
+
     const express::Router router(express::middleware::JsonMiddleware());
 
+    mqtt::lib::LatencyHistogram* adminTime = &mqtt::lib::LoopMonitor::instance().getSection("admin");
+
+    router.use("/api/bridge", [adminTime] MIDDLEWARE(req, res, next) { // cppcheck-suppress unknownMacro
+        const mqtt::lib::LoopMonitor::Timing timing(*adminTime);
+
+        next();
+    });
+
     router.get("/api/bridge/config", [] APPLICATION(req, res) { // cppcheck-suppress unknownMacro
         res->send(mqtt::bridge::lib::BridgeStore::instance().getBridgesConfigJson().dump(4));
     });
@@ -593,6 +610,14 @@ int main(int argc, char* argv[]) {
             });
     });
 
+    router.get("/api/bridge/loop", [] APPLICATION(req, res) {
+        res->send(mqtt::lib::LoopMonitor::instance().toJson().dump());
+    });
+
+    router.get("/api/bridge/sse/metrics", [] APPLICATION(req, res) {
+        res->send(mqtt::bridge::lib::SSEDistributor::instance().getEventReceiverMetrics().dump());
+    });
+
     router.get("/api/bridge/sse", [] APPLICATION(req, res) {
         if (web::http::ciContains(req->get("Accept"), "text/event-stream")) {
             res->set("Content-Type", "text/event-stream") //
@@ -65,7 +65,8 @@ namespace mqtt::mqttbroker {
             socketConnection,
             new mqtt::mqttbroker::lib::Mqtt(socketConnection->getConnectionName(),
                                             broker,
-                                            utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getMqttMapper()));
+                                            utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getMqttMapper(),
+                                            "mqtt"));
     }
 
 } // namespace mqtt::mqttbroker
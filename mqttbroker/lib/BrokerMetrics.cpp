@@ -0,0 +1,197 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "BrokerMetrics.h"
+
+#include "Mqtt.h"
+#include "MessageTap.h"
+#include "MqttModel.h"
+#include "TrafficStats.h"
+#include "lib/LatencyHistogram.h"
+#include "lib/LoopMonitor.h"
+#include "lib/MappingMetrics.h"
+#include "lib/MqttMapper.h"
+
+#include <iot/mqtt/server/broker/Broker.h>
+#include <nlohmann/json.hpp>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <sstream>
+#include <vector>
+
+#endif
+
+namespace mqtt::mqttbroker::lib {
+
+    namespace {
+
+        std::string escapeLabel(const std::string& value) {
+            std::string escaped;
+            escaped.reserve(value.size());
+
+            for (const char c : value) {
+                if (c == '\\' || c == '"') {
+                    escaped.append(1, '\\').append(1, c);
+                } else if (c == '\n') {
+                    escaped.append("\\n");
+                } else {
+                    escaped.append(1, c);
+                }
+            }
+
+            return escaped;
+        }
+
+        void family(std::ostringstream& out, const std::string& name, const std::string& type, const std::string& help) {
+            out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+        }
+
+        template <typename ValueT>
+        void sample(std::ostringstream& out, const std::string& name, const std::string& labels, ValueT value) {
+            out << name << (labels.empty() ? "" : "{" + labels + "}") << " " << value << "\n";
+        }
+
+        void summary(std::ostringstream& out,
+                     const std::string& name,
+                     const std::string& labels,
+                     const mqtt::lib::LatencyHistogram& histogram) {
+            const std::string separator = labels.empty() ? "" : ",";
+
+            for (const double quantile : {0.5, 0.9, 0.99, 0.999}) {
+                std::ostringstream quantileLabel;
+                quantileLabel << labels << separator << "quantile=\"" << quantile << "\"";
+
+                sample(out, name, quantileLabel.str(), static_cast<double>(histogram.getQuantile(quantile)) / 1e9);
+            }
+            sample(out, name + "_sum", labels, static_cast<double>(histogram.getSum()) / 1e9);
+            sample(out, name + "_count", labels, histogram.getCount());
+        }
+
+    } // namespace
+
+    BrokerMetrics& BrokerMetrics::instance() {
+        static BrokerMetrics brokerMetrics;
+
+        return brokerMetrics;
+    }
+
+    std::map<std::string, std::size_t> BrokerMetrics::getClientsByTransport() const {
+        std::map<std::string, std::size_t> clientsByTransport{{"mqtt", 0}, {"websocket", 0}};
+
+        for (const auto& [clientId, mqtt] : MqttModel::instance().getClients().getOrdered()) {
+            ++clientsByTransport[mqtt->getTransport()];
+        }
+
+        return clientsByTransport;
+    }
+
+    std::string BrokerMetrics::toPrometheus(const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker,
+                                            const std::shared_ptr<mqtt::lib::MqttMapper>& mqttMapper) const {
+        std::ostringstream out;
+
+        family(out, "mqttsuite_broker_clients_connected", "gauge", "Connected MQTT clients");
+        for (const auto& [transport, clients] : getClientsByTransport()) {
+            sample(out, "mqttsuite_broker_clients_connected", "transport=\"" + escapeLabel(transport) + "\"", clients);
+        }
+
+        family(out, "mqttsuite_broker_publishes_received_total", "counter", "Publishes received from clients");
+        sample(out, "mqttsuite_broker_publishes_received_total", "", publishesReceived.load(std::memory_order_relaxed));
+        family(out, "mqttsuite_broker_received_bytes_total", "counter", "Payload bytes of received publishes");
+        sample(out, "mqttsuite_broker_received_bytes_total", "", bytesReceived.load(std::memory_order_relaxed));
+        family(out, "mqttsuite_broker_publishes_mapped_total", "counter", "Publishes sent by the mapper");
+        sample(out, "mqttsuite_broker_publishes_mapped_total", "", publishesMapped.load(std::memory_order_relaxed));
+        family(out, "mqttsuite_broker_mapped_bytes_total", "counter", "Payload bytes of publishes sent by the mapper");
+        sample(out, "mqttsuite_broker_mapped_bytes_total", "", bytesMapped.load(std::memory_order_relaxed));
+        family(out, "mqttsuite_broker_publishes_delayed", "gauge", "Mapped publishes waiting in the delayed queues");
+        sample(out, "mqttsuite_broker_publishes_delayed", "", publishesDelayed.load(std::memory_order_relaxed));
+
+        family(out, "mqttsuite_broker_retained_messages", "gauge", "Retained messages");
+        sample(out, "mqttsuite_broker_retained_messages", "", broker->getRetainTree().size());
+
+        const nlohmann::json eventReceiverMetrics = MqttModel::instance().getEventReceiverMetrics();
+        family(out, "mqttsuite_broker_sse_receivers", "gauge", "Open server sent event streams");
+        sample(out, "mqttsuite_broker_sse_receivers", "stream=\"events\"", eventReceiverMetrics["receivers"].get<std::size_t>());
+        sample(out, "mqttsuite_broker_sse_receivers", "stream=\"stats\"", TrafficStats::instance().getReceiverCount());
+        sample(out, "mqttsuite_broker_sse_receivers", "stream=\"tap\"", MessageTap::instance().getTapCount());
+        family(out, "mqttsuite_broker_sse_frames_dropped_total", "counter", "Dashboard events dropped for receivers over budget");
+        sample(out, "mqttsuite_broker_sse_frames_dropped_total", "", eventReceiverMetrics["frames_dropped"].get<std::uint64_t>());
+
+        family(out, "mqttsuite_broker_onpublish_seconds", "summary", "Wall time of onPublish");
+        summary(out, "mqttsuite_broker_onpublish_seconds", "", mqtt::lib::LoopMonitor::instance().getSection("onPublish"));
+
+        if (mqttMapper != nullptr && mqttMapper->getMetrics() != nullptr) {
+            const std::vector<const mqtt::lib::MappingMetrics::RuleMetrics*> rules = mqttMapper->getMetrics()->getActiveRules();
+
+            std::vector<std::string> ruleLabels;
+            for (const mqtt::lib::MappingMetrics::RuleMetrics* rule : rules) {
+                ruleLabels.push_back("topic=\"" + escapeLabel(rule->topic) + "\",type=\"" + escapeLabel(rule->type) + "\",index=\"" +
+                                     std::to_string(rule->index) + "\"");
+            }
+
+            const std::vector<std::pair<std::string, std::atomic<std::uint64_t> mqtt::lib::MappingMetrics::RuleMetrics::*>> counters = {
+                {"matches", &mqtt::lib::MappingMetrics::RuleMetrics::matches},
+                {"emitted", &mqtt::lib::MappingMetrics::RuleMetrics::emitted},
+                {"suppressed", &mqtt::lib::MappingMetrics::RuleMetrics::suppressed},
+                {"render_errors", &mqtt::lib::MappingMetrics::RuleMetrics::renderErrors},
+                {"parse_failures", &mqtt::lib::MappingMetrics::RuleMetrics::parseFailures},
+                {"rate_limited", &mqtt::lib::MappingMetrics::RuleMetrics::rateLimited},
+                {"coalesced", &mqtt::lib::MappingMetrics::RuleMetrics::coalesced}};
+
+            for (const auto& [counter, member] : counters) {
+                const std::string name = "mqttsuite_mapper_rule_" + counter + "_total";
+
+                family(out, name, "counter", "Mapping rule " + counter);
+                for (std::size_t i = 0; i < rules.size(); i++) {
+                    sample(out, name, ruleLabels[i], (rules[i]->*member).load(std::memory_order_relaxed));
+                }
+            }
+
+            family(out, "mqttsuite_mapper_rule_latency_seconds", "summary", "Match plus render time of a mapping rule");
+            for (std::size_t i = 0; i < rules.size(); i++) {
+                summary(out, "mqttsuite_mapper_rule_latency_seconds", ruleLabels[i], rules[i]->latency);
+            }
+        }
+
+        return out.str();
+    }
+
+} // namespace mqtt::mqttbroker::lib
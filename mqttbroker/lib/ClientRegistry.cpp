@@ -0,0 +1,268 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "ClientRegistry.h"
+
+#include "Mqtt.h"
+
+#include <core/socket/stream/SocketConnection.h>
+#include <iot/mqtt/MqttContext.h>
+#include <net/SocketAddress.h>
+#include <nlohmann/json.hpp>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#endif
+
+namespace mqtt::mqttbroker::lib {
+
+    template <typename IndexT>
+    static void eraseFromIndex(IndexT& index, const typename IndexT::key_type& key, std::string_view clientId) {
+        auto [begin, end] = index.equal_range(key);
+
+        auto it = std::find_if(begin, end, [clientId](const auto& indexEntry) {
+            return indexEntry.second.data() == clientId.data();
+        });
+        if (it != end) {
+            index.erase(it);
+        }
+    }
+
+    ClientRegistry::Selector ClientRegistry::Selector::fromJson(const nlohmann::json& json) {
+        Selector selector;
+
+        if (!json.is_object()) {
+            throw std::invalid_argument("Selector must be an object");
+        }
+
+        for (const auto& [key, value] : json.items()) {
+            if (key == "username" && value.is_string()) {
+                selector.username = value.get<std::string>();
+            } else if (key == "address" && value.is_string()) {
+                selector.addressRange = parseCidr(value.get<std::string>());
+            } else if (key == "connected_before" && value.is_number()) {
+                selector.connectedBefore = TimePoint(std::chrono::seconds(value.get<std::int64_t>()));
+            } else if (key == "connected_after" && value.is_number()) {
+                selector.connectedAfter = TimePoint(std::chrono::seconds(value.get<std::int64_t>()));
+            } else {
+                throw std::invalid_argument("Invalid selector attribute '" + key + "'");
+            }
+        }
+
+        if (!selector.username && !selector.addressRange && !selector.connectedBefore && !selector.connectedAfter) {
+            throw std::invalid_argument("Empty selector");
+        }
+
+        return selector;
+    }
+
+    bool ClientRegistry::add(Mqtt* mqtt) {
+        const auto [it, inserted] = clients.try_emplace(mqtt->getClientId(),
+                                                        Entry{mqtt,
+                                                              mqtt->getUsername(),
+                                                              parseAddress(mqtt->getMqttContext()
+                                                                               ->getSocketConnection()
+                                                                               ->getRemoteAddress()
+                                                                               .toString()),
+                                                              std::chrono::system_clock::now()});
+
+        if (inserted) {
+            const std::string_view clientId = it->first;
+            const Entry& entry = it->second;
+
+            ordered.emplace(clientId, mqtt);
+            byUsername[entry.username].insert(clientId);
+            if (entry.address) {
+                byAddress.emplace(*entry.address, clientId);
+            }
+            byConnectTime.emplace(entry.connectedAt, clientId);
+        }
+
+        return inserted;
+    }
+
+    void ClientRegistry::remove(const std::string& clientId) {
+        auto it = clients.find(clientId);
+
+        if (it != clients.end()) {
+            const std::string_view key = it->first;
+            const Entry& entry = it->second;
+
+            ordered.erase(key);
+
+            auto usernameIt = byUsername.find(entry.username);
+            usernameIt->second.erase(key);
+            if (usernameIt->second.empty()) {
+                byUsername.erase(usernameIt);
+            }
+
+            if (entry.address) {
+                eraseFromIndex(byAddress, *entry.address, key);
+            }
+            eraseFromIndex(byConnectTime, entry.connectedAt, key);
+
+            clients.erase(it);
+        }
+    }
+
+    Mqtt* ClientRegistry::find(const std::string& clientId) const {
+        auto it = clients.find(clientId);
+
+        return it != clients.end() ? it->second.mqtt : nullptr;
+    }
+
+    bool ClientRegistry::contains(const std::string& clientId) const {
+        return clients.contains(clientId);
+    }
+
+    bool ClientRegistry::matches(const Entry& entry, const Selector& selector) const {
+        return (!selector.username || entry.username == *selector.username) &&
+               (!selector.addressRange ||
+                (entry.address && *entry.address >= selector.addressRange->first && *entry.address <= selector.addressRange->second)) &&
+               (!selector.connectedBefore || entry.connectedAt < *selector.connectedBefore) &&
+               (!selector.connectedAfter || entry.connectedAt >= *selector.connectedAfter);
+    }
+
+    std::vector<Mqtt*> ClientRegistry::select(const Selector& selector) const {
+        std::vector<Mqtt*> selected;
+
+        // Candidates come from the most selective index given, the remaining criteria are checked per candidate
+        auto check = [this, &selector, &selected](std::string_view clientId) {
+            const Entry& entry = clients.find(std::string(clientId))->second;
+
+            if (matches(entry, selector)) {
+                selected.push_back(entry.mqtt);
+            }
+        };
+
+        if (selector.username) {
+            auto usernameIt = byUsername.find(*selector.username);
+            if (usernameIt != byUsername.end()) {
+                std::ranges::for_each(usernameIt->second, check);
+            }
+        } else if (selector.addressRange) {
+            auto end = byAddress.upper_bound(selector.addressRange->second);
+            for (auto it = byAddress.lower_bound(selector.addressRange->first); it != end; ++it) {
+                check(it->second);
+            }
+        } else if (!selector.connectedAfter || !selector.connectedBefore || *selector.connectedAfter < *selector.connectedBefore) {
+            auto begin = selector.connectedAfter ? byConnectTime.lower_bound(*selector.connectedAfter) : byConnectTime.begin();
+            auto end = selector.connectedBefore ? byConnectTime.lower_bound(*selector.connectedBefore) : byConnectTime.end();
+            for (auto it = begin; it != end; ++it) {
+                check(it->second);
+            }
+        }
+
+        return selected;
+    }
+
+    const std::map<std::string_view, Mqtt*, std::less<>>& ClientRegistry::getOrdered() const {
+        return ordered;
+    }
+
+    std::optional<ClientRegistry::Address> ClientRegistry::parseAddress(std::string_view address) {
+        std::optional<Address> parsed;
+
+        // "1.2.3.4:port", "[::1]:port", or an address without port
+        std::string host(address);
+        if (host.starts_with('[')) {
+            host = host.substr(1, host.find(']') - 1);
+        } else if (std::ranges::count(host, ':') == 1) {
+            host = host.substr(0, host.find(':'));
+        }
+
+        Address bytes{};
+        in_addr ipv4{};
+        if (inet_pton(AF_INET, host.c_str(), &ipv4) == 1) {
+            bytes[10] = bytes[11] = 0xff;
+            std::memcpy(bytes.data() + 12, &ipv4, sizeof(ipv4));
+            parsed = bytes;
+        } else if (inet_pton(AF_INET6, host.c_str(), bytes.data()) == 1) {
+            parsed = bytes;
+        } else if (host.find(':') != std::string::npos &&
+                   inet_pton(AF_INET6, host.substr(0, host.rfind(':')).c_str(), bytes.data()) == 1) { // "::1:port"
+            parsed = bytes;
+        }
+
+        return parsed;
+    }
+
+    std::pair<ClientRegistry::Address, ClientRegistry::Address> ClientRegistry::parseCidr(const std::string& cidr) {
+        const std::size_t slash = cidr.find('/');
+        const std::string host = cidr.substr(0, slash);
+
+        std::optional<Address> address = parseAddress(host.find(':') != std::string::npos ? "[" + host + "]" : host);
+        if (!address) {
+            throw std::invalid_argument("Invalid address '" + cidr + "'");
+        }
+
+        const bool ipv4 = host.find(':') == std::string::npos;
+        const std::size_t maxLength = ipv4 ? 32 : 128;
+
+        std::size_t prefixLength = maxLength;
+        if (slash != std::string::npos) {
+            const std::string length = cidr.substr(slash + 1);
+            if (length.empty() || length.size() > 3 || !std::ranges::all_of(length, ::isdigit) || std::stoul(length) > maxLength) {
+                throw std::invalid_argument("Invalid prefix length in '" + cidr + "'");
+            }
+            prefixLength = std::stoul(length);
+        }
+        prefixLength += 128 - maxLength;
+
+        Address first = *address;
+        Address last = *address;
+        for (std::size_t bit = prefixLength; bit < 128; ++bit) {
+            const auto mask = static_cast<std::uint8_t>(0x80 >> (bit % 8));
+            first[bit / 8] = static_cast<std::uint8_t>(first[bit / 8] & ~mask);
+            last[bit / 8] = static_cast<std::uint8_t>(last[bit / 8] | mask);
+        }
+
+        return {first, last};
+    }
+
+} // namespace mqtt::mqttbroker::lib
@@ -0,0 +1,120 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTBROKER_LIB_CLIENTREGISTRY_H
+#define MQTTBROKER_LIB_CLIENTREGISTRY_H
+
+namespace mqtt::mqttbroker::lib {
+    class Mqtt;
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <nlohmann/json_fwd.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#endif
+
+namespace mqtt::mqttbroker::lib {
+
+    /*
+     * Connected clients by client id, with secondary indexes by username, remote address and connect time. All indexes refer to
+     * the client id stored as key of the primary hash map, whose nodes do not move.
+     */
+    class ClientRegistry {
+    public:
+        using Address = std::array<std::uint8_t, 16>; // IPv6, IPv4 as v4-mapped address
+        using TimePoint = std::chrono::system_clock::time_point;
+
+        // All given criteria must hold
+        struct Selector {
+            std::optional<std::string> username;
+            std::optional<std::pair<Address, Address>> addressRange; // first and last address of a CIDR block
+            std::optional<TimePoint> connectedBefore;
+            std::optional<TimePoint> connectedAfter;
+
+            static Selector fromJson(const nlohmann::json& json); // can throw std::invalid_argument
+        };
+
+        bool add(Mqtt* mqtt);
+        void remove(const std::string& clientId);
+
+        Mqtt* find(const std::string& clientId) const;
+        bool contains(const std::string& clientId) const;
+
+        std::vector<Mqtt*> select(const Selector& selector) const;
+
+        const std::map<std::string_view, Mqtt*, std::less<>>& getOrdered() const;
+
+        static std::optional<Address> parseAddress(std::string_view address);
+        static std::pair<Address, Address> parseCidr(const std::string& cidr); // can throw std::invalid_argument
+
+    private:
+        struct Entry {
+            Mqtt* mqtt;
+            std::string username;
+            std::optional<Address> address;
+            TimePoint connectedAt;
+        };
+
+        bool matches(const Entry& entry, const Selector& selector) const;
+
+        std::unordered_map<std::string, Entry> clients;
+
+        std::map<std::string_view, Mqtt*, std::less<>> ordered;
+        std::unordered_map<std::string, std::unordered_set<std::string_view>> byUsername;
+        std::multimap<Address, std::string_view> byAddress;
+        std::multimap<TimePoint, std::string_view> byConnectTime;
+    };
+
+} // namespace mqtt::mqttbroker::lib
+
+#endif // MQTTBROKER_LIB_CLIENTREGISTRY_H
@@ -0,0 +1,197 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "MessageTap.h"
+
+#include "MqttModel.h"
+
+#include <core/socket/stream/SocketConnection.h>
+#include <express/Response.h>
+#include <iot/mqtt/packets/Publish.h>
+#include <nlohmann/json.hpp>
+#include <web/http/server/SocketContext.h>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <algorithm>
+#include <log/Logger.h>
+#include <utility>
+
+#endif
+
+namespace mqtt::mqttbroker::lib {
+
+    namespace {
+
+        constexpr double FLUSH_INTERVAL = 1;
+
+        // Samples for a receiver having this much unsent are dropped
+        constexpr std::size_t RECEIVER_BACKLOG_LIMIT = 256 * 1024;
+
+    } // namespace
+
+    MessageTap::Tap::Tap(std::uint64_t id, const std::shared_ptr<express::Response>& response, const Options& options)
+        : id(id)
+        , response(response)
+        , options(options)
+        , heartbeatTimer(core::timer::Timer::intervalTimer(
+              [response] {
+                  if (response->isConnected()) {
+                      response->sendFragment(":keep-alive\r\n");
+                  }
+              },
+              39)) {
+        reservoir.reserve(options.every == 0 ? options.reservoir : 0);
+    }
+
+    MessageTap::Tap::~Tap() {
+        flushTimer.cancel();
+        heartbeatTimer.cancel();
+    }
+
+    MessageTap& MessageTap::instance() {
+        static MessageTap messageTap;
+
+        return messageTap;
+    }
+
+    void MessageTap::addTap(const std::shared_ptr<express::Response>& response, const Options& options) {
+        const std::uint64_t tapId = nextTapId++;
+
+        Tap& tap = taps.emplace_back(tapId, response, options);
+
+        if (options.every == 0) {
+            tap.flushTimer = core::timer::Timer::intervalTimer(
+                [this, &tap]() {
+                    flush(tap);
+                },
+                FLUSH_INTERVAL);
+        }
+
+        response->getSocketContext()->onDisconnected([this, tapId]() {
+            taps.remove_if([tapId](const Tap& tap) {
+                return tap.id == tapId;
+            });
+        });
+
+        VLOG(1) << "Message tap " << tapId << ": filter '" << options.filter << "', "
+                << (options.every > 0 ? "every " + std::to_string(options.every) : "reservoir " + std::to_string(options.reservoir));
+    }
+
+    std::size_t MessageTap::getTapCount() const {
+        return taps.size();
+    }
+
+    void MessageTap::tap(const std::string& clientId, const iot::mqtt::packets::Publish& publish) {
+        for (Tap& tap : taps) {
+            if (MqttModel::topicMatches(tap.options.filter, publish.getTopic())) {
+                ++tap.seen;
+
+                if (tap.options.every > 0) {
+                    if ((tap.seen - 1) % tap.options.every == 0) {
+                        send(tap, sample(clientId, publish, tap.options.maxPayload));
+                    }
+                } else if (tap.reservoir.size() < tap.options.reservoir) {
+                    tap.reservoir.push_back(sample(clientId, publish, tap.options.maxPayload));
+                } else {
+                    // Algorithm R: the n-th publish replaces a random sample with probability reservoir / n
+                    const std::uint64_t slot = std::uniform_int_distribution<std::uint64_t>(0, tap.seen - 1)(random);
+
+                    if (slot < tap.reservoir.size()) {
+                        tap.reservoir[slot] = sample(clientId, publish, tap.options.maxPayload);
+                    }
+                }
+            }
+        }
+    }
+
+    void MessageTap::flush(Tap& tap) {
+        if (tap.seen > 0) {
+            for (const Sample& sample : tap.reservoir) {
+                send(tap, sample);
+            }
+            send(tap, "sample", nlohmann::json({{"seen", tap.seen}, {"sampled", tap.reservoir.size()}, {"dropped", tap.dropped}}).dump());
+
+            tap.reservoir.clear();
+            tap.seen = 0;
+        }
+    }
+
+    MessageTap::Sample
+    MessageTap::sample(const std::string& clientId, const iot::mqtt::packets::Publish& publish, std::size_t maxPayload) {
+        const std::string& message = publish.getMessage();
+
+        return {clientId,
+                publish.getTopic(),
+                message.substr(0, std::min(message.size(), maxPayload)),
+                message.size(),
+                publish.getQoS(),
+                publish.getRetain()};
+    }
+
+    void MessageTap::send(Tap& tap, const std::string& event, const std::string& data) {
+        const std::shared_ptr<express::Response> response = tap.response.lock();
+
+        if (response != nullptr && response->isConnected()) {
+            const core::socket::stream::SocketConnection* socketConnection = response->getSocketContext()->getSocketConnection();
+
+            if (socketConnection->getTotalQueued() - socketConnection->getTotalSent() < RECEIVER_BACKLOG_LIMIT) {
+                response->sendFragment("event:" + event + "\r\ndata:" + data + "\r\n");
+            } else {
+                ++tap.dropped;
+            }
+        }
+    }
+
+    void MessageTap::send(Tap& tap, const Sample& sample) {
+        const nlohmann::json json = {{"clientId", sample.clientId},
+                                     {"topic", sample.topic},
+                                     {"qos", sample.qoS},
+                                     {"retain", sample.retain},
+                                     {"size", sample.size},
+                                     {"payload", sample.payload},
+                                     {"truncated", sample.payload.size() < sample.size}};
+
+        // Binary or cut off payloads are not valid UTF-8
+        send(tap, "message", json.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace));
+    }
+
+} // namespace mqtt::mqttbroker::lib
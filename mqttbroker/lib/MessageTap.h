@@ -0,0 +1,138 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTBROKER_LIB_MESSAGETAP_H
+#define MQTTBROKER_LIB_MESSAGETAP_H
+
+#include <core/timer/Timer.h>
+
+namespace express {
+    class Response;
+}
+
+namespace iot::mqtt::packets {
+    class Publish;
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#endif
+
+namespace mqtt::mqttbroker::lib {
+
+    // Live samples of the publishes the broker receives from clients, sent to dashboards as server sent "message" events. Without
+    // taps the publish path only checks isActive().
+    class MessageTap {
+    public:
+        struct Options {
+            std::string filter = "#";
+            std::size_t every = 0;      // send every n-th matching publish, 0 = use the reservoir
+            std::size_t reservoir = 20; // uniform sample of at most that many matching publishes per second
+            std::size_t maxPayload = 256;
+        };
+
+        MessageTap(const MessageTap&) = delete;
+        MessageTap& operator=(const MessageTap&) = delete;
+
+        static MessageTap& instance();
+
+        bool isActive() const {
+            return !taps.empty();
+        }
+
+        void tap(const std::string& clientId, const iot::mqtt::packets::Publish& publish);
+
+        void addTap(const std::shared_ptr<express::Response>& response, const Options& options);
+        std::size_t getTapCount() const;
+
+    private:
+        MessageTap() = default;
+
+        struct Sample {
+            std::string clientId;
+            std::string topic;
+            std::string payload; // truncated to maxPayload
+            std::size_t size;
+            std::uint8_t qoS;
+            bool retain;
+        };
+
+        class Tap {
+        public:
+            Tap(std::uint64_t id, const std::shared_ptr<express::Response>& response, const Options& options);
+            ~Tap();
+
+            std::uint64_t id;
+            std::weak_ptr<express::Response> response;
+            Options options;
+
+            std::uint64_t seen = 0;    // matching publishes, of the current second for the reservoir
+            std::uint64_t dropped = 0; // samples not sent because the receiver lagged
+
+            std::vector<Sample> reservoir;
+            core::timer::Timer flushTimer;
+
+            core::timer::Timer heartbeatTimer;
+        };
+
+        static Sample sample(const std::string& clientId, const iot::mqtt::packets::Publish& publish, std::size_t maxPayload);
+        static void send(Tap& tap, const std::string& event, const std::string& data);
+        static void send(Tap& tap, const Sample& sample);
+
+        void flush(Tap& tap);
+
+        std::list<Tap> taps;
+        std::uint64_t nextTapId = 0;
+
+        std::minstd_rand random{std::random_device{}()};
+    };
+
+} // namespace mqtt::mqttbroker::lib
+
+#endif // MQTTBROKER_LIB_MESSAGETAP_H
@@ -43,8 +43,12 @@
 
 #include "Mqtt.h"
 
+#include "lib/LoopMonitor.h"
 #include "lib/MqttMapper.h"
+#include "mqttbroker/lib/BrokerMetrics.h"
+#include "mqttbroker/lib/MessageTap.h"
 #include "mqttbroker/lib/MqttModel.h"
+#include "mqttbroker/lib/TrafficStats.h"
 
 #include <iot/mqtt/packets/Publish.h>
 #include <iot/mqtt/packets/Subscribe.h>
@@ -53,8 +57,11 @@
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <list>
+#include <utility>
 
 #endif
 
@@ -63,15 +70,18 @@ namespace mqtt::mqttbroker::lib {
     struct Mqtt::ScheduledPublish {
         utils::Timeval when;
         std::size_t seq;
-        iot::mqtt::packets::Publish publish;
+        std::shared_ptr<const iot::mqtt::packets::Publish> publish;
         utils::Timeval delay;
+        std::shared_ptr<mqtt::lib::CoalescedPublish> coalescedPublish; // the latest value is taken when due
     };
 
     Mqtt::Mqtt(const std::string& connectionName,
                const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker,
-               const std::shared_ptr<mqtt::lib::MqttMapper>& mqttMapper)
+               const std::shared_ptr<mqtt::lib::MqttMapper>& mqttMapper,
+               const std::string& transport)
         : iot::mqtt::server::Mqtt(connectionName, broker)
         , mqttMapper(mqttMapper)
+        , transport(transport)
         , delayedQueue(this) {
     }
 
@@ -89,19 +99,27 @@ namespace mqtt::mqttbroker::lib {
 
     Mqtt::DelayedQueue::~DelayedQueue() {
         delayTimer.cancel();
+
+        BrokerMetrics::instance().publishesDelayed.fetch_sub(static_cast<std::int64_t>(minHeap.size()), std::memory_order_relaxed);
     }
 
     void Mqtt::DelayedQueue::processDue() {
         const auto now = utils::Timeval::currentTime();
 
         while (!empty() && top().when <= now) {
-            const iot::mqtt::packets::Publish duePublish = top().publish;
+            std::shared_ptr<const iot::mqtt::packets::Publish> duePublish = top().publish;
+            if (top().coalescedPublish != nullptr) {
+                duePublish = top().coalescedPublish->take().first;
+            }
             pop();
 
             mqtt->broker->publish(
-                mqtt->clientId, duePublish.getTopic(), duePublish.getMessage(), duePublish.getQoS(), duePublish.getRetain());
+                mqtt->clientId, duePublish->getTopic(), duePublish->getMessage(), duePublish->getQoS(), duePublish->getRetain());
 
-            mqtt->onPublish(duePublish);
+            BrokerMetrics::instance().publishesMapped.fetch_add(1, std::memory_order_relaxed);
+            BrokerMetrics::instance().bytesMapped.fetch_add(duePublish->getMessage().size(), std::memory_order_relaxed);
+
+            mqtt->mapPublish(*duePublish);
         }
     }
 
@@ -124,8 +142,11 @@ namespace mqtt::mqttbroker::lib {
             delay);
     }
 
-    void Mqtt::DelayedQueue::delayPublish(const utils::Timeval& delay, const iot::mqtt::packets::Publish& publish) {
-        minHeap.push({utils::Timeval::currentTime() + delay, nextSeq++, publish, delay});
+    void Mqtt::DelayedQueue::delayPublish(const utils::Timeval& delay,
+                                          std::shared_ptr<const iot::mqtt::packets::Publish> publish,
+                                          std::shared_ptr<mqtt::lib::CoalescedPublish> coalescedPublish) {
+        minHeap.push({utils::Timeval::currentTime() + delay, nextSeq++, std::move(publish), delay, std::move(coalescedPublish)});
+        BrokerMetrics::instance().publishesDelayed.fetch_add(1, std::memory_order_relaxed);
         armDelayTimer();
     }
 
@@ -139,6 +160,7 @@ namespace mqtt::mqttbroker::lib {
 
     void Mqtt::DelayedQueue::pop() {
         minHeap.pop();
+        BrokerMetrics::instance().publishesDelayed.fetch_sub(1, std::memory_order_relaxed);
     }
 
     void Mqtt::subscribe(const std::string& topic, uint8_t qoS) {
@@ -151,29 +173,59 @@ namespace mqtt::mqttbroker::lib {
         onUnsubscribe(iot::mqtt::packets::Unsubscribe(0, {{topic, 0}}));
     }
 
+    const std::string& Mqtt::getTransport() const {
+        return transport;
+    }
+
     void Mqtt::onConnect([[maybe_unused]] const iot::mqtt::packets::Connect& connect) {
         MqttModel::instance().connectClient(this);
     }
 
     void Mqtt::onPublish(const iot::mqtt::packets::Publish& publish) {
-        MqttModel::instance().publishMessage(publish.getTopic(), publish.getMessage(), publish.getQoS(), publish.getRetain());
+        static mqtt::lib::LatencyHistogram& onPublishTime = mqtt::lib::LoopMonitor::instance().getSection("onPublish");
+        const mqtt::lib::LoopMonitor::Timing timing(onPublishTime);
 
-        if (mqttMapper != nullptr) {
-            const auto& [immediatePublishes, scheduledPublishes] = mqttMapper->getMappings(publish);
+        BrokerMetrics::instance().publishesReceived.fetch_add(1, std::memory_order_relaxed);
+        BrokerMetrics::instance().bytesReceived.fetch_add(publish.getMessage().size(), std::memory_order_relaxed);
 
-            for (const mqtt::lib::MqttMapper::ScheduledPublish& delayedPublish : scheduledPublishes) {
-                delayedQueue.delayPublish(delayedPublish.delay, delayedPublish.publish);
-            }
+        TrafficStats::instance().record(clientId, publish.getTopic(), publish.getMessage().size());
+        if (MessageTap::instance().isActive()) {
+            MessageTap::instance().tap(clientId, publish);
+        }
 
-            for (const iot::mqtt::packets::Publish& immediatePublish : immediatePublishes) {
-                broker->publish(clientId,
-                                immediatePublish.getTopic(),
-                                immediatePublish.getMessage(),
-                                immediatePublish.getQoS(),
-                                immediatePublish.getRetain());
+        mapPublish(publish);
+    }
 
-                onPublish(immediatePublish);
-            }
+    void Mqtt::mapPublish(const iot::mqtt::packets::Publish& publish) {
+        MqttModel::instance().publishMessage(publish.getTopic(), publish.getMessage(), publish.getQoS(), publish.getRetain());
+
+        if (mqttMapper != nullptr) {
+            mqttMapper->getMappings(
+                publish, [this, weakAlive = std::weak_ptr<bool>(alive)](mqtt::lib::MqttMapper::MappedPublishes&& mappedPublishes) {
+                    if (!weakAlive.expired()) {
+                        auto& [immediatePublishes, scheduledPublishes] = mappedPublishes;
+
+                        for (mqtt::lib::MqttMapper::ScheduledPublish& delayedPublish : scheduledPublishes) {
+                            delayedQueue.delayPublish(
+                                delayedPublish.delay, std::move(delayedPublish.publish), std::move(delayedPublish.coalescedPublish));
+                        }
+
+                        for (const mqtt::lib::MqttMapper::MappedPublish& immediatePublish : immediatePublishes) {
+                            broker->publish(clientId,
+                                            immediatePublish.publish.getTopic(),
+                                            immediatePublish.publish.getMessage(),
+                                            immediatePublish.publish.getQoS(),
+                                            immediatePublish.publish.getRetain());
+
+                            BrokerMetrics::instance().publishesMapped.fetch_add(1, std::memory_order_relaxed);
+                            BrokerMetrics::instance().bytesMapped.fetch_add(immediatePublish.publish.getMessage().size(),
+                                                                            std::memory_order_relaxed);
+
+                            mapPublish(immediatePublish.publish);
+                        }
+                    }
+                },
+                this);
         }
     }
 
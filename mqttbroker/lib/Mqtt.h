@@ -56,8 +56,9 @@ namespace iot::mqtt {
 } // namespace iot::mqtt
 
 namespace mqtt::lib {
+    class CoalescedPublish;
     class MqttMapper;
-}
+} // namespace mqtt::lib
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
@@ -76,11 +77,14 @@ namespace mqtt::mqttbroker::lib {
     public:
         explicit Mqtt(const std::string& connectionName,
                       const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker,
-                      const std::shared_ptr<mqtt::lib::MqttMapper>& mqttMapper);
+                      const std::shared_ptr<mqtt::lib::MqttMapper>& mqttMapper,
+                      const std::string& transport);
 
         void subscribe(const std::string& topic, uint8_t qoS);
         void unsubscribe(const std::string& topic);
 
+        const std::string& getTransport() const;
+
     private:
         struct ScheduledPublish;
 
@@ -93,7 +97,9 @@ namespace mqtt::mqttbroker::lib {
             explicit DelayedQueue(Mqtt* mqtt);
             ~DelayedQueue();
 
-            void delayPublish(const utils::Timeval& delay, const iot::mqtt::packets::Publish& publish);
+            void delayPublish(const utils::Timeval& delay,
+                              std::shared_ptr<const iot::mqtt::packets::Publish> publish,
+                              std::shared_ptr<mqtt::lib::CoalescedPublish> coalescedPublish);
 
             bool empty() const;
             const ScheduledPublish& top() const;
@@ -111,12 +117,16 @@ namespace mqtt::mqttbroker::lib {
 
         void onConnect(const iot::mqtt::packets::Connect& connect) final;
         void onPublish(const iot::mqtt::packets::Publish& publish) final;
+        void mapPublish(const iot::mqtt::packets::Publish& publish); // publishes of the mapper re-enter here, not via onPublish
         void onSubscribe(const iot::mqtt::packets::Subscribe& subscribe) final;
         void onUnsubscribe(const iot::mqtt::packets::Unsubscribe& unsubscribe) final;
         void onDisconnected() final;
 
         std::shared_ptr<mqtt::lib::MqttMapper> mqttMapper;
+        std::string transport; // "mqtt" or "websocket"
         DelayedQueue delayedQueue;
+
+        std::shared_ptr<bool> alive = std::make_shared<bool>(true); // expires mapping results delivered after destruction
     };
 
 } // namespace mqtt::mqttbroker::lib
@@ -55,13 +55,19 @@
 
 // IWYU pragma: no_include <nlohmann/detail/json_ref.hpp>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
 #include <ctime>
 #include <functional>
 #include <iomanip>
 #include <log/Logger.h>
+#include <memory>
 #include <sstream>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 struct tm;
 
@@ -155,25 +161,35 @@ namespace mqtt::mqttbroker::lib {
         j = {{"topic", release.topic}};
     }
 
+    // Bytes written to the response but not yet handed to the kernel
+    static std::size_t backlogOf(const std::shared_ptr<express::Response>& response) {
+        const core::socket::stream::SocketConnection* socketConnection = response->getSocketContext()->getSocketConnection();
+
+        return socketConnection->getTotalQueued() - socketConnection->getTotalSent();
+    }
+
     MqttModel::EventReceiver::EventReceiver(std::uint64_t id, const std::shared_ptr<express::Response>& response)
         : id(id)
         , response(response)
         , heartbeatTimer(core::timer::Timer::intervalTimer(
               [response] {
-                  if (response->isConnected()) {
-                      response->sendFragment(":keep-alive");
-                      response->sendFragment();
-                  }
+                  static const Frame keepAlive = std::make_shared<const std::string>(":keep-alive\r\n");
+
+                  sendFrame(response, keepAlive);
               },
               39)) {
     }
 
     MqttModel::EventReceiver::~EventReceiver() {
         heartbeatTimer.cancel();
+        drainTimer.cancel();
     }
 
     MqttModel::MqttModel()
-        : onlineSinceTimePoint(std::chrono::system_clock::now()) {
+        : onlineSinceTimePoint(std::chrono::system_clock::now())
+        // Event ids start at the startup time in µs so that a Last-Event-ID of a previous run does not resume
+        , id(static_cast<std::uint64_t>(
+              std::chrono::duration_cast<std::chrono::microseconds>(onlineSinceTimePoint.time_since_epoch()).count())) {
     }
 
     MqttModel& MqttModel::instance() {
@@ -183,11 +199,17 @@ namespace mqtt::mqttbroker::lib {
     }
 
     void MqttModel::addEventReceiver(const std::shared_ptr<express::Response>& response,
-                                     [[maybe_unused]] const std::string& lastEventId,
-                                     const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker) {
+                                     const std::string& lastEventId,
+                                     const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker,
+                                     bool clientsOnly) {
         const std::uint64_t eventReceiverId = nextEventReceiverId++;
 
-        eventReceiverList.emplace_back(eventReceiverId, response);
+        // The snapshot below already reflects the pending events, so existing receivers get them first. This also puts them
+        // into replayEvents for resuming.
+        flushEvents();
+
+        EventReceiver& eventReceiver = eventReceiverList.emplace_back(eventReceiverId, response);
+        eventReceiver.clientsOnly = clientsOnly;
 
         response->getSocketContext()->onDisconnected([this, eventReceiverId]() {
             eventReceiverList.remove_if([eventReceiverId](const EventReceiver& eventReceiver) {
@@ -195,6 +217,176 @@ namespace mqtt::mqttbroker::lib {
             });
         });
 
+        this->broker = broker;
+
+        if (!resume(response, lastEventId)) {
+            sendSnapshot(response, clientsOnly);
+        }
+        eventReceiver.snapshotBacklog = backlogOf(response);
+    }
+
+    template <typename MapT, typename MatchT, typename ToJsonT>
+    static nlohmann::json queryPage(const MapT& map, const MqttModel::PageQuery& pageQuery, MatchT matches, ToJsonT toJson) {
+        nlohmann::json items = nlohmann::json::array();
+        std::string next;
+
+        // Keys are sorted, so a prefix selects a contiguous range and a page starts right behind the cursor. The scan stops at the
+        // first match past the page, which only tells that there is a next page.
+        auto it = pageQuery.cursor > pageQuery.prefix ? map.upper_bound(pageQuery.cursor) : map.lower_bound(pageQuery.prefix);
+        for (; it != map.end() && it->first.starts_with(pageQuery.prefix) && next.empty(); ++it) {
+            if (matches(it->first)) {
+                if (items.size() < pageQuery.limit) {
+                    items.push_back(toJson(it->first, it->second));
+                } else {
+                    next = items.back()["key"].template get<std::string>();
+                }
+            }
+        }
+
+        nlohmann::json page = {{"items", items}, {"count", nullptr}, {"total", map.size()}, {"next", nullptr}};
+        if (!next.empty()) {
+            page["next"] = next;
+        }
+
+        if (pageQuery.count) {
+            std::size_t count = 0;
+
+            for (it = map.lower_bound(pageQuery.prefix); it != map.end() && it->first.starts_with(pageQuery.prefix); ++it) {
+                count += matches(it->first) ? 1 : 0;
+            }
+
+            page["count"] = count;
+        }
+
+        return page;
+    }
+
+    nlohmann::json MqttModel::queryClients(const PageQuery& pageQuery) const {
+        return queryPage(
+            clientRegistry.getOrdered(),
+            pageQuery,
+            [](std::string_view) {
+                return true;
+            },
+            [](std::string_view clientId, const Mqtt* mqtt) {
+                nlohmann::json item = mqtt;
+                item["key"] = clientId;
+
+                return item;
+            });
+    }
+
+    nlohmann::json MqttModel::querySubscriptions(const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker,
+                                                 const PageQuery& pageQuery) {
+        return queryPage(
+            broker->getSubscriptionTree(),
+            pageQuery,
+            [&pageQuery](const std::string& topic) {
+                return pageQuery.filter.empty() || topicMatches(pageQuery.filter, topic);
+            },
+            [](const std::string& topic, const auto& clients) {
+                nlohmann::json subscribers = nlohmann::json::array();
+                for (const auto& client : clients) {
+                    subscribers.push_back({{"clientId", client.first}, {"qos", client.second}});
+                }
+
+                return nlohmann::json({{"key", topic}, {"topic", topic}, {"subscribers", subscribers}});
+            });
+    }
+
+    nlohmann::json MqttModel::queryRetained(const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker, const PageQuery& pageQuery) {
+        return queryPage(
+            broker->getRetainTree(),
+            pageQuery,
+            [&pageQuery](const std::string& topic) {
+                return pageQuery.filter.empty() || topicMatches(pageQuery.filter, topic);
+            },
+            [](const std::string& topic, const auto& retained) {
+                nlohmann::json item = retaine{topic, retained.first, retained.second};
+                item["key"] = topic;
+
+                return item;
+            });
+    }
+
+    bool MqttModel::topicMatches(const std::string& filter, const std::string& topic) {
+        // Wildcards in the first level do not match topics starting with '$'
+        bool matches = !topic.starts_with('$') || (!filter.starts_with('+') && !filter.starts_with('#'));
+        bool matchesRest = false;
+
+        std::size_t filterPos = 0;
+        std::size_t topicPos = 0;
+        while (matches && !matchesRest && filterPos <= filter.size()) {
+            const std::size_t filterEnd = std::min(filter.find('/', filterPos), filter.size());
+            const std::string_view filterLevel = std::string_view(filter).substr(filterPos, filterEnd - filterPos);
+
+            if (filterLevel == "#") {
+                matchesRest = true; // including the parent level
+            } else if (topicPos > topic.size()) {
+                matches = false;
+            } else {
+                const std::size_t topicEnd = std::min(topic.find('/', topicPos), topic.size());
+
+                matches = filterLevel == "+" || filterLevel == std::string_view(topic).substr(topicPos, topicEnd - topicPos);
+                topicPos = topicEnd + 1;
+            }
+
+            filterPos = filterEnd + 1;
+        }
+
+        return matches && (matchesRest || topicPos > topic.size());
+    }
+
+    bool MqttModel::resume(const std::shared_ptr<express::Response>& response, const std::string& lastEventId) {
+        bool resumed = false;
+
+        char* end = nullptr;
+        const std::uint64_t lastId = std::strtoull(lastEventId.c_str(), &end, 10);
+
+        // Only ids of replayable events qualify: a receiver interrupted within a snapshot has not seen all of it
+        if (!lastEventId.empty() && *end == '\0') {
+            auto eventIt = std::lower_bound(replayEvents.begin(), replayEvents.end(), lastId, [](const Event& event, std::uint64_t id) {
+                return event.id < id;
+            });
+
+            if (eventIt != replayEvents.end() && eventIt->id == lastId) {
+                std::string missed;
+                for (++eventIt; eventIt != replayEvents.end(); ++eventIt) {
+                    appendFrame(missed, eventIt->frame);
+                }
+
+                VLOG(1) << "Server sent events: Receiver resumed after event " << lastId << " with " << missed.size() << " bytes";
+
+                if (!missed.empty()) {
+                    sendFrame(response, std::make_shared<const std::string>(std::move(missed)));
+                }
+
+                ++receiversResumed;
+                resumed = true;
+            }
+        }
+
+        return resumed;
+    }
+
+    void MqttModel::remember(const Event& event) {
+        if (eventReplaySize > 0) {
+            replayEvents.push_back(event);
+
+            while (replayEvents.size() > eventReplaySize) {
+                replayEvents.pop_front();
+            }
+        }
+    }
+
+    void MqttModel::sendSnapshot(const std::shared_ptr<express::Response>& response, bool clientsOnly) {
+        const std::shared_ptr<iot::mqtt::server::broker::Broker> broker = this->broker.lock();
+        if (!broker) {
+            return;
+        }
+
+        ++snapshotsSent;
+
         /*
             {
                 "title": "MQTTBroker",
@@ -218,79 +410,98 @@ namespace mqtt::mqttbroker::lib {
                 "duration": "2 days, 03:45:12"
             }
         */
-        sendJsonEvent(response,
-                      {
-                          {"title", "MQTTBroker"},
-                          {"creator", {{"name", "Volker Christian"}, {"url", "https://github.com/VolkerChristian"}}},
-                          {"broker", {{"name", "MQTTBroker"}, {"url", "https://github.com/SNodeC/mqttsuite/tree/master/mqttbroker"}}},
-                          {"suite", {{"name", "MQTTSuite"}, {"url", "https://github.com/SNodeC/mqttsuite"}}},
-                          {"snodec", {{"name", "SNode.C"}, {"url", "https://github.com/SNodeC/snode.c"}}},
-                          {"since", onlineSince()},
-                          {"duration", onlineDuration()},
-                      },
-                      "ui-initialize",
-                      std::to_string(id++));
-
-        for (const auto& modelMapEntry : modelMap) {
-            sendJsonEvent(response, modelMapEntry.second, "client-connected", std::to_string(id++));
-        }
-
-        for (const auto& [topic, clients] : broker->getSubscriptionTree()) {
-            for (const auto& client : clients) {
-                sendJsonEvent(response, subscribe{topic, client.first, client.second}, "client-subscribed", std::to_string(id++));
-            }
+        const nlohmann::json uiInitialize = {
+            {"title", "MQTTBroker"},
+            {"creator", {{"name", "Volker Christian"}, {"url", "https://github.com/VolkerChristian"}}},
+            {"broker", {{"name", "MQTTBroker"}, {"url", "https://github.com/SNodeC/mqttsuite/tree/master/mqttbroker"}}},
+            {"suite", {{"name", "MQTTSuite"}, {"url", "https://github.com/SNodeC/mqttsuite"}}},
+            {"snodec", {{"name", "SNode.C"}, {"url", "https://github.com/SNodeC/snode.c"}}},
+            {"since", onlineSince()},
+            {"duration", onlineDuration()},
+        };
+
+        // The whole snapshot goes out as one write
+        std::string snapshot;
+        appendFrame(snapshot, frameEvent(uiInitialize.dump(), "ui-initialize", std::to_string(id++)));
+
+        for (const auto& [clientId, mqtt] : clientRegistry.getOrdered()) {
+            appendFrame(snapshot, frameEvent(nlohmann::json(mqtt).dump(), "client-connected", std::to_string(id++)));
         }
 
-        for (const auto& [topic, retained] : broker->getRetainTree()) {
-            sendJsonEvent(response, retaine{topic, retained.first, retained.second}, "retained-message-set", std::to_string(id++));
+        if (!clientsOnly) {
+            for (const auto& [topic, clients] : broker->getSubscriptionTree()) {
+                for (const auto& client : clients) {
+                    appendFrame(snapshot,
+                                frameEvent(nlohmann::json(subscribe{topic, client.first, client.second}).dump(),
+                                           "client-subscribed",
+                                           std::to_string(id++)));
+                }
+            }
+
+            for (const auto& [topic, retained] : broker->getRetainTree()) {
+                appendFrame(snapshot,
+                            frameEvent(nlohmann::json(retaine{topic, retained.first, retained.second}).dump(),
+                                       "retained-message-set",
+                                       std::to_string(id++)));
+            }
         }
+
+        sendFrame(response, std::make_shared<const std::string>(std::move(snapshot)));
     }
 
     void MqttModel::connectClient(Mqtt* mqtt) {
-        modelMap.emplace(mqtt->getClientId(), mqtt);
+        clientRegistry.add(mqtt);
+
+        // Pending events of a previous connection of this client id are not cancelled together with this connection
+        pendingByClient.erase(mqtt->getClientId());
 
-        sendJsonEvent(mqtt, "client-connected", std::to_string(id++));
+        sendJsonEvent(mqtt, "client-connected", mqtt->getClientId());
+
+        if (eventBatchWindow > 0 && !eventReceiverList.empty()) {
+            pendingConnects.insert(mqtt->getClientId());
+        }
     }
 
     void MqttModel::disconnectClient(const std::string& clientId) {
-        if (modelMap.contains(clientId)) {
-            sendJsonEvent(modelMap[clientId], "client-disconnected", std::to_string(id++));
+        Mqtt* mqtt = clientRegistry.find(clientId);
 
-            modelMap.erase(clientId);
+        if (mqtt != nullptr) {
+            if (!cancelPendingConnect(clientId)) {
+                sendJsonEvent(mqtt, "client-disconnected", clientId);
+            }
+
+            clientRegistry.remove(clientId);
         }
     }
 
     void MqttModel::subscribeClient(const std::string& clientId, const std::string& topic, const uint8_t qos) {
-        sendJsonEvent(subscribe{topic, clientId, qos}, "client-subscribed", std::to_string(id++));
+        sendJsonEvent(subscribe{topic, clientId, qos}, "client-subscribed", clientId, "s:" + clientId + "\n" + topic);
     }
 
     void MqttModel::unsubscribeClient(const std::string& clientId, const std::string& topic) {
-        sendJsonEvent(unsubscribe{clientId, topic}, "client-unsubscribed", std::to_string(id++));
+        sendJsonEvent(unsubscribe{clientId, topic}, "client-unsubscribed", clientId, "s:" + clientId + "\n" + topic);
     }
 
     void MqttModel::publishMessage(const std::string& topic, const std::string& message, uint8_t qoS, bool retain) {
         if (retain) {
             if (!message.empty()) {
-                sendJsonEvent(retaine{topic, message, qoS}, "retained-message-set", std::to_string(id++));
+                sendJsonEvent(retaine{topic, message, qoS}, "retained-message-set", "", "r:" + topic);
             } else {
-                sendJsonEvent(release{topic}, "retained-message-deleted", std::to_string(id++));
+                sendJsonEvent(release{topic}, "retained-message-deleted", "", "r:" + topic);
             }
         }
     }
 
-    const std::map<std::string, Mqtt*>& MqttModel::getClients() const {
-        return modelMap;
+    const ClientRegistry& MqttModel::getClients() const {
+        return clientRegistry;
     }
 
     Mqtt* MqttModel::getMqtt(const std::string& clientId) const {
-        Mqtt* mqtt = nullptr;
-
-        auto modelIt = modelMap.find(clientId);
-        if (modelIt != modelMap.end()) {
-            mqtt = modelIt->second;
-        }
+        return clientRegistry.find(clientId);
+    }
 
-        return mqtt;
+    std::vector<Mqtt*> MqttModel::selectClients(const ClientRegistry::Selector& selector) const {
+        return clientRegistry.select(selector);
     }
 
     std::string MqttModel::onlineSince() const {
@@ -301,41 +512,230 @@ namespace mqtt::mqttbroker::lib {
         return durationToString(onlineSinceTimePoint);
     }
 
-    void MqttModel::sendEvent(const std::shared_ptr<express::Response>& response,
-                              const std::string& data,
-                              const std::string& event,
-                              const std::string& id) {
+    void MqttModel::setEventLogLevel(int eventLogLevel) {
+        this->eventLogLevel = eventLogLevel;
+    }
+
+    void MqttModel::setEventBatchWindow(std::size_t eventBatchWindow) {
+        flushEvents();
+
+        this->eventBatchWindow = eventBatchWindow;
+    }
+
+    void MqttModel::setEventReceiverBudget(std::size_t eventReceiverBudget, OverflowPolicy overflowPolicy) {
+        this->eventReceiverBudget = eventReceiverBudget;
+        this->overflowPolicy = overflowPolicy;
+    }
+
+    void MqttModel::setEventReplaySize(std::size_t eventReplaySize) {
+        this->eventReplaySize = eventReplaySize;
+
+        while (replayEvents.size() > eventReplaySize) {
+            replayEvents.pop_front();
+        }
+    }
+
+    MqttModel::OverflowPolicy MqttModel::parseOverflowPolicy(const std::string& overflowPolicy) {
+        return overflowPolicy == "disconnect" ? OverflowPolicy::DISCONNECT : OverflowPolicy::SNAPSHOT;
+    }
+
+    nlohmann::json MqttModel::getEventReceiverMetrics() const {
+        std::size_t snapshotPending = 0;
+        for (const EventReceiver& eventReceiver : eventReceiverList) {
+            snapshotPending += eventReceiver.snapshotRequired ? 1 : 0;
+        }
+
+        return {{"receivers", eventReceiverList.size()},
+                {"budget", eventReceiverBudget},
+                {"overflow_policy", overflowPolicy == OverflowPolicy::DISCONNECT ? "disconnect" : "snapshot"},
+                {"snapshot_pending", snapshotPending},
+                {"snapshots_required", snapshotsRequired},
+                {"receivers_disconnected", receiversDisconnected},
+                {"frames_dropped", framesDropped},
+                {"replay_size", eventReplaySize},
+                {"replay_events", replayEvents.size()},
+                {"receivers_resumed", receiversResumed},
+                {"snapshots_sent", snapshotsSent}};
+    }
+
+    MqttModel::Frame MqttModel::frameEvent(const std::string& data, const std::string& event, const std::string& id) {
+        std::string frame;
+        frame.reserve(event.size() + id.size() + data.size() + 24);
+
+        if (!event.empty()) {
+            frame.append("event:").append(event).append("\r\n");
+        }
+        if (!id.empty()) {
+            frame.append("id:").append(id).append("\r\n");
+        }
+        frame.append("data:").append(data).append("\r\n");
+
+        return std::make_shared<const std::string>(std::move(frame));
+    }
+
+    void MqttModel::sendFrame(const std::shared_ptr<express::Response>& response, const Frame& frame) {
         if (response->isConnected()) {
-            if (!event.empty()) {
-                response->sendFragment("event:" + event);
-            }
-            if (!id.empty()) {
-                response->sendFragment("id:" + id);
-            }
-            response->sendFragment("data:" + data);
-            response->sendFragment();
+            response->sendFragment(*frame); // the trailing line break of the fragment terminates the event
         }
     }
 
-    void MqttModel::sendJsonEvent(const std::shared_ptr<express::Response>& response,
-                                  const nlohmann::json& json,
+    void MqttModel::sendJsonEvent(const nlohmann::json& json,
                                   const std::string& event,
-                                  const std::string& id) {
-        sendEvent(response, json.dump(), event, id);
+                                  const std::string& clientId,
+                                  const std::string& coalesceKey) {
+        const std::uint64_t eventId = id++;
+
+        VLOG(eventLogLevel) << "Server sent event: " << event << "\n" << json.dump(4);
+
+        // Without receivers the event is still remembered for those reconnecting later
+        if (!eventReceiverList.empty() || eventReplaySize > 0) {
+            const Event sseEvent{eventId, frameEvent(json.dump(), event, std::to_string(eventId))};
+
+            // While a batch is pending, later events queue behind it even if the last receiver left meanwhile, so that replayEvents
+            // stays ordered by id
+            if ((eventBatchWindow > 0 && !eventReceiverList.empty()) || !pendingEvents.empty()) {
+                queueEvent(sseEvent, clientId, coalesceKey);
+            } else {
+                remember(sseEvent);
+                sendFrame(sseEvent.frame);
+            }
+        }
     }
 
-    void MqttModel::sendEvent(const std::string& data, const std::string& event, const std::string& id) const {
+    void MqttModel::sendFrame(const Frame& frame) {
+        std::vector<std::shared_ptr<express::Response>> overBudget;
+
         for (auto& eventReceiver : eventReceiverList) {
             if (const auto& response = eventReceiver.response.lock()) {
-                sendEvent(response, data, event, id);
+                const std::size_t backlog = response->isConnected() ? backlogOf(response) : 0;
+                eventReceiver.snapshotBacklog = std::min(eventReceiver.snapshotBacklog, backlog);
+
+                if (eventReceiver.snapshotRequired) {
+                    ++framesDropped;
+                } else if (eventReceiverBudget > 0 && response->isConnected() &&
+                           backlog - eventReceiver.snapshotBacklog + frame->size() > eventReceiverBudget) {
+                    ++framesDropped;
+
+                    if (overflowPolicy == OverflowPolicy::DISCONNECT) {
+                        overBudget.push_back(response);
+                    } else {
+                        overflow(eventReceiver, response);
+                    }
+                } else {
+                    sendFrame(response, frame);
+                }
             }
         }
+
+        // Closing may remove receivers from eventReceiverList, thus not while iterating it
+        for (const auto& response : overBudget) {
+            LOG(WARNING) << "Server sent events: Receiver " << response->getSocketContext()->getSocketConnection()->getConnectionName()
+                         << " over budget, disconnecting";
+
+            ++receiversDisconnected;
+            response->getSocketContext()->getSocketConnection()->close();
+        }
+    }
+
+    void MqttModel::overflow(EventReceiver& eventReceiver, const std::shared_ptr<express::Response>& response) {
+        VLOG(1) << "Server sent events: Receiver " << response->getSocketContext()->getSocketConnection()->getConnectionName()
+                << " over budget, dropping events until it drained";
+
+        ++snapshotsRequired;
+        eventReceiver.snapshotRequired = true;
+
+        eventReceiver.drainTimer = core::timer::Timer::intervalTimer(
+            [this, &eventReceiver]() {
+                const std::shared_ptr<express::Response> response = eventReceiver.response.lock();
+
+                if (!response || !response->isConnected()) {
+                    eventReceiver.drainTimer.cancel();
+                } else if (backlogOf(response) <= eventReceiverBudget / 4) {
+                    eventReceiver.drainTimer.cancel();
+                    eventReceiver.snapshotRequired = false;
+
+                    VLOG(1) << "Server sent events: Receiver " << response->getSocketContext()->getSocketConnection()->getConnectionName()
+                            << " drained, sending snapshot";
+
+                    flushEvents();
+                    sendSnapshot(response, eventReceiver.clientsOnly);
+                    eventReceiver.snapshotBacklog = backlogOf(response);
+                }
+            },
+            0.5);
+    }
+
+    void MqttModel::appendFrame(std::string& batch, const Frame& frame) {
+        if (!batch.empty()) {
+            batch.append("\r\n"); // blank line terminating the previous event
+        }
+        batch.append(*frame);
+    }
+
+    void MqttModel::queueEvent(const Event& event, const std::string& clientId, const std::string& coalesceKey) {
+        if (pendingEvents.empty()) {
+            eventBatchTimer = core::timer::Timer::singleshotTimer(
+                [this]() {
+                    flushEvents();
+                },
+                static_cast<double>(eventBatchWindow) / 1000.);
+        }
+
+        const std::size_t index = pendingEvents.size();
+        pendingEvents.push_back(event);
+
+        if (!coalesceKey.empty()) {
+            auto [it, inserted] = pendingByKey.try_emplace(coalesceKey, index);
+            if (!inserted) {
+                pendingEvents[it->second].frame = nullptr; // the later event supersedes the earlier one
+                it->second = index;
+            }
+        }
+
+        if (!clientId.empty()) {
+            pendingByClient[clientId].push_back(index);
+        }
     }
 
-    void MqttModel::sendJsonEvent(const nlohmann::json& json, const std::string& event, const std::string& id) const {
-        VLOG(0) << "Server sent event: " << event << "\n" << json.dump(4);
+    bool MqttModel::cancelPendingConnect(const std::string& clientId) {
+        const bool cancel = pendingConnects.erase(clientId) > 0;
+
+        // Receivers never learned about this client, so none of its events of this window are of interest
+        if (cancel) {
+            for (const std::size_t index : pendingByClient[clientId]) {
+                pendingEvents[index].frame = nullptr;
+            }
+            pendingByClient.erase(clientId);
+        }
+
+        return cancel;
+    }
 
-        sendEvent(json.dump(), event, id);
+    void MqttModel::flushEvents() {
+        eventBatchTimer.cancel();
+
+        std::string batch;
+        std::size_t sent = 0;
+        for (const Event& event : pendingEvents) {
+            if (event.frame != nullptr) {
+                appendFrame(batch, event.frame);
+                remember(event);
+                ++sent;
+            }
+        }
+
+        if (!pendingEvents.empty()) {
+            VLOG(eventLogLevel) << "Server sent events: " << pendingEvents.size() << " queued, " << sent << " sent after coalescing";
+        }
+
+        pendingEvents.clear();
+        pendingByKey.clear();
+        pendingByClient.clear();
+        pendingConnects.clear();
+
+        if (!batch.empty()) {
+            sendFrame(std::make_shared<const std::string>(std::move(batch)));
+        }
     }
 
     std::string MqttModel::timePointToString(const std::chrono::time_point<std::chrono::system_clock>& timePoint) {
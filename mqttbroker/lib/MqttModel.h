@@ -42,6 +42,8 @@
 #ifndef MQTTBROKER_LIB_MQTTMODEL_H
 #define MQTTBROKER_LIB_MQTTMODEL_H
 
+#include "ClientRegistry.h"
+
 #include <core/timer/Timer.h>
 
 namespace mqtt::mqttbroker::lib {
@@ -62,11 +64,15 @@ namespace iot::mqtt {
 
 #include <chrono>
 #include <cstdint>
+#include <deque>
 #include <list>
 #include <map>
 #include <memory>
 #include <nlohmann/json_fwd.hpp>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #endif
 
@@ -88,17 +94,46 @@ namespace mqtt::mqttbroker::lib {
             std::weak_ptr<express::Response> response;
 
             core::timer::Timer heartbeatTimer;
+
+            // Set while the receiver is over its byte budget: deltas are dropped until it drains and gets a fresh snapshot
+            bool snapshotRequired = false;
+            core::timer::Timer drainTimer;
+
+            // Backlog left by the last snapshot (or replay), lowered as it drains. Only the backlog above it counts against the
+            // budget, so a snapshot larger than the budget does not immediately require the next one.
+            std::size_t snapshotBacklog = 0;
+
+            bool clientsOnly = false;
         };
 
     private:
         MqttModel();
 
     public:
+        enum class OverflowPolicy { SNAPSHOT, DISCONNECT };
+
+        struct PageQuery {
+            std::string cursor; // key of the last item of the previous page
+            std::string prefix; // keys starting with
+            std::string filter; // topics matching this MQTT topic filter, '+' and '#' are wildcards
+            std::size_t limit = 100;
+            bool count = false; // also count all matching items, which scans the whole prefix range
+        };
+
         static MqttModel& instance();
 
+        // With clientsOnly the snapshot leaves out subscriptions and retained messages, which are then fetched page by page
         void addEventReceiver(const std::shared_ptr<express::Response>& response,
                               const std::string& lastEventId,
-                              const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker);
+                              const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker,
+                              bool clientsOnly = false);
+
+        nlohmann::json queryClients(const PageQuery& pageQuery) const;
+        static nlohmann::json querySubscriptions(const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker,
+                                                 const PageQuery& pageQuery);
+        static nlohmann::json queryRetained(const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker, const PageQuery& pageQuery);
+
+        static bool topicMatches(const std::string& filter, const std::string& topic);
 
         void connectClient(Mqtt* mqtt);
         void disconnectClient(const std::string& clientId);
@@ -106,35 +141,85 @@ namespace mqtt::mqttbroker::lib {
         void unsubscribeClient(const std::string& clientId, const std::string& topic);
         void publishMessage(const std::string& topic, const std::string& message, uint8_t qoS, bool retain);
 
-        const std::map<std::string, Mqtt*>& getClients() const;
+        const ClientRegistry& getClients() const;
 
         Mqtt* getMqtt(const std::string& clientId) const;
+        std::vector<Mqtt*> selectClients(const ClientRegistry::Selector& selector) const;
 
         std::string onlineSince() const;
         std::string onlineDuration() const;
 
+        void setEventLogLevel(int eventLogLevel);
+        void setEventBatchWindow(std::size_t eventBatchWindow); // in ms, 0 sends every event immediately
+        void setEventReceiverBudget(std::size_t eventReceiverBudget, OverflowPolicy overflowPolicy); // in bytes, 0 = unlimited
+        void setEventReplaySize(std::size_t eventReplaySize); // events kept for resuming receivers, 0 = always send a snapshot
+
+        static OverflowPolicy parseOverflowPolicy(const std::string& overflowPolicy);
+
+        nlohmann::json getEventReceiverMetrics() const;
+
     private:
-        static void sendEvent(const std::shared_ptr<express::Response>& response,
-                              const std::string& data,
-                              const std::string& event,
-                              const std::string& id);
-        static void sendJsonEvent(const std::shared_ptr<express::Response>& response,
-                                  const nlohmann::json& json,
-                                  const std::string& event = "",
-                                  const std::string& id = "");
-        void sendEvent(const std::string& data, const std::string& event = "", const std::string& id = "") const;
-        void sendJsonEvent(const nlohmann::json& json, const std::string& event = "", const std::string& id = "") const;
+        // A complete SSE event ("event:", "id:" and "data:" lines) shared by all receivers it is written to
+        using Frame = std::shared_ptr<const std::string>;
+
+        struct Event {
+            std::uint64_t id;
+            Frame frame;
+        };
+
+        static Frame frameEvent(const std::string& data, const std::string& event, const std::string& id);
+        static void sendFrame(const std::shared_ptr<express::Response>& response, const Frame& frame);
+
+        void sendJsonEvent(const nlohmann::json& json,
+                           const std::string& event,
+                           const std::string& clientId,
+                           const std::string& coalesceKey = "");
+        void sendFrame(const Frame& frame);
+        void sendSnapshot(const std::shared_ptr<express::Response>& response, bool clientsOnly);
+        bool resume(const std::shared_ptr<express::Response>& response, const std::string& lastEventId);
+        void remember(const Event& event);
+
+        void overflow(EventReceiver& eventReceiver, const std::shared_ptr<express::Response>& response);
+
+        static void appendFrame(std::string& batch, const Frame& frame);
+
+        void queueEvent(const Event& event, const std::string& clientId, const std::string& coalesceKey);
+        bool cancelPendingConnect(const std::string& clientId);
+        void flushEvents();
 
         static std::string timePointToString(const std::chrono::time_point<std::chrono::system_clock>& timePoint);
         static std::string
         durationToString(const std::chrono::time_point<std::chrono::system_clock>& bevore,
                          const std::chrono::time_point<std::chrono::system_clock>& later = std::chrono::system_clock::now());
 
-        std::map<std::string, Mqtt*> modelMap;
+        ClientRegistry clientRegistry;
         std::list<EventReceiver> eventReceiverList;
         std::chrono::time_point<std::chrono::system_clock> onlineSinceTimePoint;
         std::uint64_t nextEventReceiverId = 0;
         uint64_t id = 0;
+        int eventLogLevel = 2;
+
+        // Batching: events of one window, the frames of superseded ones reset to nullptr
+        std::size_t eventBatchWindow = 0;
+        core::timer::Timer eventBatchTimer;
+        std::vector<Event> pendingEvents;
+        std::unordered_map<std::string, std::size_t> pendingByKey;
+        std::unordered_map<std::string, std::vector<std::size_t>> pendingByClient;
+        std::unordered_set<std::string> pendingConnects;
+
+        // Backpressure: bytes a receiver may have queued but not yet sent
+        std::weak_ptr<iot::mqtt::server::broker::Broker> broker;
+        std::size_t eventReceiverBudget = 0;
+        OverflowPolicy overflowPolicy = OverflowPolicy::SNAPSHOT;
+        std::uint64_t framesDropped = 0;
+        std::uint64_t snapshotsRequired = 0;
+        std::uint64_t receiversDisconnected = 0;
+
+        // Resuming: the most recent events sent, ascending by id
+        std::size_t eventReplaySize = 0;
+        std::deque<Event> replayEvents;
+        std::uint64_t receiversResumed = 0;
+        std::uint64_t snapshotsSent = 0;
     };
 
 } // namespace mqtt::mqttbroker::lib
@@ -0,0 +1,190 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "SysTree.h"
+
+#include "BrokerMetrics.h"
+#include "MqttModel.h"
+#include "lib/MappingMetrics.h"
+#include "lib/MqttMapper.h"
+
+#include <iot/mqtt/server/broker/Broker.h>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <cmath>
+#include <iomanip>
+#include <log/Logger.h>
+#include <sstream>
+#include <vector>
+
+#endif
+
+namespace mqtt::mqttbroker::lib {
+
+    namespace {
+
+        constexpr std::array<double, 3> LOAD_MINUTES{1, 5, 15};
+
+        std::string toString(double value) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(2) << value;
+
+            return out.str();
+        }
+
+    } // namespace
+
+    void SysTree::Load::update(std::uint64_t total, double seconds) {
+        const double rate = static_cast<double>(total - lastTotal) / seconds;
+        lastTotal = total;
+
+        for (std::size_t i = 0; i < averages.size(); i++) {
+            averages[i] += (1 - std::exp(-seconds / (60 * LOAD_MINUTES[i]))) * (rate - averages[i]);
+        }
+    }
+
+    SysTree& SysTree::instance() {
+        static SysTree sysTree;
+
+        return sysTree;
+    }
+
+    void SysTree::start(const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker,
+                        const std::shared_ptr<mqtt::lib::MqttMapper>& mqttMapper,
+                        double interval) {
+        this->broker = broker;
+        this->mqttMapper = mqttMapper;
+
+        publishTimer.cancel();
+
+        if (interval > 0) {
+            const BrokerMetrics& brokerMetrics = BrokerMetrics::instance();
+
+            messagesReceived.lastTotal = brokerMetrics.publishesReceived.load(std::memory_order_relaxed);
+            messagesMapped.lastTotal = brokerMetrics.publishesMapped.load(std::memory_order_relaxed);
+            bytesReceived.lastTotal = brokerMetrics.bytesReceived.load(std::memory_order_relaxed);
+            bytesMapped.lastTotal = brokerMetrics.bytesMapped.load(std::memory_order_relaxed);
+
+            startTime = lastTick = std::chrono::steady_clock::now();
+
+            publishTimer = core::timer::Timer::intervalTimer(
+                [this]() {
+                    publishTree();
+                },
+                interval);
+
+            VLOG(1) << "$SYS/broker: published every " << interval << " s";
+        }
+    }
+
+    void SysTree::publishTree() {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(now - lastTick).count();
+        lastTick = now;
+
+        const BrokerMetrics& brokerMetrics = BrokerMetrics::instance();
+
+        const std::uint64_t publishesReceived = brokerMetrics.publishesReceived.load(std::memory_order_relaxed);
+        const std::uint64_t publishesMapped = brokerMetrics.publishesMapped.load(std::memory_order_relaxed);
+        const std::uint64_t totalBytesReceived = brokerMetrics.bytesReceived.load(std::memory_order_relaxed);
+        const std::uint64_t totalBytesMapped = brokerMetrics.bytesMapped.load(std::memory_order_relaxed);
+
+        if (seconds > 0) {
+            messagesReceived.update(publishesReceived, seconds);
+            messagesMapped.update(publishesMapped, seconds);
+            bytesReceived.update(totalBytesReceived, seconds);
+            bytesMapped.update(totalBytesMapped, seconds);
+        }
+
+        publish("$SYS/broker/uptime", std::to_string(std::chrono::duration_cast<std::chrono::seconds>(now - startTime).count()));
+
+        std::size_t clientsConnected = 0;
+        for (const auto& [transport, clients] : brokerMetrics.getClientsByTransport()) {
+            publish("$SYS/broker/clients/" + transport, std::to_string(clients));
+            clientsConnected += clients;
+        }
+        publish("$SYS/broker/clients/connected", std::to_string(clientsConnected));
+
+        publish("$SYS/broker/messages/received", std::to_string(publishesReceived));
+        publish("$SYS/broker/messages/mapped", std::to_string(publishesMapped));
+        publish("$SYS/broker/bytes/received", std::to_string(totalBytesReceived));
+        publish("$SYS/broker/bytes/mapped", std::to_string(totalBytesMapped));
+
+        publishLoad("$SYS/broker/load/messages/received", messagesReceived);
+        publishLoad("$SYS/broker/load/messages/mapped", messagesMapped);
+        publishLoad("$SYS/broker/load/bytes/received", bytesReceived);
+        publishLoad("$SYS/broker/load/bytes/mapped", bytesMapped);
+
+        publish("$SYS/broker/retained messages/count", std::to_string(broker->getRetainTree().size()));
+
+        publish("$SYS/broker/mapper/delayed", std::to_string(brokerMetrics.publishesDelayed.load(std::memory_order_relaxed)));
+        if (mqttMapper != nullptr && mqttMapper->getMetrics() != nullptr) {
+            std::uint64_t matches = 0;
+            std::uint64_t emitted = 0;
+
+            for (const mqtt::lib::MappingMetrics::RuleMetrics* rule : mqttMapper->getMetrics()->getActiveRules()) {
+                matches += rule->matches.load(std::memory_order_relaxed);
+                emitted += rule->emitted.load(std::memory_order_relaxed);
+            }
+
+            publish("$SYS/broker/mapper/matches", std::to_string(matches));
+            publish("$SYS/broker/mapper/emitted", std::to_string(emitted));
+        }
+    }
+
+    void SysTree::publishLoad(const std::string& topic, const Load& load) {
+        for (std::size_t i = 0; i < LOAD_MINUTES.size(); i++) {
+            publish(topic + "/" + std::to_string(static_cast<int>(LOAD_MINUTES[i])) + "min", toString(load.averages[i]));
+        }
+    }
+
+    void SysTree::publish(const std::string& topic, const std::string& value) {
+        std::string& last = published[topic];
+
+        if (last != value) {
+            last = value;
+
+            broker->publish("", topic, value, 0, true);
+        }
+    }
+
+} // namespace mqtt::mqttbroker::lib
@@ -0,0 +1,113 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTBROKER_LIB_SYSTREE_H
+#define MQTTBROKER_LIB_SYSTREE_H
+
+#include <core/timer/Timer.h>
+
+namespace iot::mqtt::server::broker {
+    class Broker;
+}
+
+namespace mqtt::lib {
+    class MqttMapper;
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#endif
+
+namespace mqtt::mqttbroker::lib {
+
+    // Periodically publishes broker and mapper statistics retained to $SYS/broker/..., from the counters also served by the admin
+    // APIs. Topics whose value did not change since the last publish are skipped.
+    class SysTree {
+    public:
+        SysTree(const SysTree&) = delete;
+        SysTree& operator=(const SysTree&) = delete;
+
+        static SysTree& instance();
+
+        void start(const std::shared_ptr<iot::mqtt::server::broker::Broker>& broker,
+                   const std::shared_ptr<mqtt::lib::MqttMapper>& mqttMapper,
+                   double interval); // in seconds, 0 disables the tree
+
+    private:
+        SysTree() = default;
+
+        // Per second rate averaged over 1, 5 and 15 minutes, like the load averages of mosquitto
+        struct Load {
+            void update(std::uint64_t total, double seconds);
+
+            std::uint64_t lastTotal = 0;
+            std::array<double, 3> averages{};
+        };
+
+        void publishTree();
+        void publishLoad(const std::string& topic, const Load& load);
+        void publish(const std::string& topic, const std::string& value);
+
+        std::shared_ptr<iot::mqtt::server::broker::Broker> broker;
+        std::shared_ptr<mqtt::lib::MqttMapper> mqttMapper;
+
+        Load messagesReceived;
+        Load messagesMapped;
+        Load bytesReceived;
+        Load bytesMapped;
+
+        std::map<std::string, std::string> published; // last value of each topic
+
+        std::chrono::steady_clock::time_point startTime;
+        std::chrono::steady_clock::time_point lastTick;
+        core::timer::Timer publishTimer;
+    };
+
+} // namespace mqtt::mqttbroker::lib
+
+#endif // MQTTBROKER_LIB_SYSTREE_H
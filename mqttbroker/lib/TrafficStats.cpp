@@ -0,0 +1,232 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "TrafficStats.h"
+
+#include <core/socket/stream/SocketConnection.h>
+#include <express/Response.h>
+#include <nlohmann/json.hpp>
+#include <web/http/server/SocketContext.h>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <cmath>
+#include <log/Logger.h>
+
+#endif
+
+namespace mqtt::mqttbroker::lib {
+
+    namespace {
+
+        constexpr double TICK_INTERVAL = 1;
+        constexpr double RATE_TIME_CONSTANT = 10; // seconds
+
+        // A receiver still having this much unsent skips ticks, the next one carries the current numbers anyway
+        constexpr std::size_t RECEIVER_BACKLOG_LIMIT = 64 * 1024;
+
+    } // namespace
+
+    void TrafficStats::HeavyHitters::setCapacity(std::size_t capacity) {
+        this->capacity = capacity;
+
+        counters.clear();
+        counters.reserve(capacity);
+        index.clear();
+        byCount.clear();
+    }
+
+    void TrafficStats::HeavyHitters::add(const std::string& key, std::uint64_t weight) {
+        if (capacity > 0 && weight > 0) {
+            auto it = index.find(key);
+
+            if (it != index.end()) {
+                Counter& counter = counters[it->second];
+
+                byCount.erase({counter.count, it->second});
+                counter.count += weight;
+                counter.pending += weight;
+                byCount.emplace(counter.count, it->second);
+            } else if (counters.size() < capacity) {
+                it = index.emplace(key, counters.size()).first;
+
+                counters.push_back({&it->first, weight, 0, weight, 0});
+                byCount.emplace(weight, it->second);
+            } else {
+                const std::size_t slot = byCount.begin()->second;
+                Counter& counter = counters[slot];
+
+                byCount.erase(byCount.begin());
+                index.erase(index.find(*counter.key));
+
+                it = index.emplace(key, slot).first;
+
+                counter = {&it->first, counter.count + weight, counter.count, weight, 0};
+                byCount.emplace(counter.count, slot);
+            }
+        }
+    }
+
+    void TrafficStats::HeavyHitters::tick(double seconds, double alpha) {
+        for (Counter& counter : counters) {
+            counter.rate += alpha * (static_cast<double>(counter.pending) / seconds - counter.rate);
+            counter.pending = 0;
+        }
+    }
+
+    nlohmann::json TrafficStats::HeavyHitters::top(std::size_t n) const {
+        nlohmann::json top = nlohmann::json::array();
+
+        for (auto it = byCount.rbegin(); it != byCount.rend() && top.size() < n; ++it) {
+            const Counter& counter = counters[it->second];
+
+            top.push_back({{"key", *counter.key}, {"count", counter.count}, {"error", counter.error}, {"rate", counter.rate}});
+        }
+
+        return top;
+    }
+
+    TrafficStats& TrafficStats::instance() {
+        static TrafficStats trafficStats;
+
+        return trafficStats;
+    }
+
+    void TrafficStats::setCapacity(std::size_t capacity) {
+        this->capacity = capacity;
+
+        topicMessages.setCapacity(capacity);
+        topicBytes.setCapacity(capacity);
+        clientMessages.setCapacity(capacity);
+        clientBytes.setCapacity(capacity);
+    }
+
+    void TrafficStats::record(const std::string& clientId, const std::string& topic, std::size_t bytes) {
+        if (capacity > 0) {
+            start();
+
+            topicMessages.add(topic, 1);
+            topicBytes.add(topic, bytes);
+            clientMessages.add(clientId, 1);
+            clientBytes.add(clientId, bytes);
+
+            ++messages;
+            ++pendingMessages;
+            this->bytes += bytes;
+            pendingBytes += bytes;
+        }
+    }
+
+    nlohmann::json TrafficStats::top(std::size_t n) const {
+        return {{"capacity", capacity},
+                {"totals", {{"messages", messages}, {"bytes", bytes}, {"message_rate", messageRate}, {"byte_rate", byteRate}}},
+                {"topics", {{"messages", topicMessages.top(n)}, {"bytes", topicBytes.top(n)}}},
+                {"clients", {{"messages", clientMessages.top(n)}, {"bytes", clientBytes.top(n)}}}};
+    }
+
+    void TrafficStats::addReceiver(const std::shared_ptr<express::Response>& response, std::size_t n) {
+        const std::uint64_t receiverId = nextReceiverId++;
+
+        receivers.push_back({receiverId, response, n});
+
+        response->getSocketContext()->onDisconnected([this, receiverId]() {
+            receivers.remove_if([receiverId](const Receiver& receiver) {
+                return receiver.id == receiverId;
+            });
+        });
+
+        response->sendFragment("event:traffic-stats\r\ndata:" + top(n).dump() + "\r\n");
+
+        start();
+    }
+
+    std::size_t TrafficStats::getReceiverCount() const {
+        return receivers.size();
+    }
+
+    void TrafficStats::start() {
+        if (!started) {
+            started = true;
+            lastTick = std::chrono::steady_clock::now();
+
+            tickTimer = core::timer::Timer::intervalTimer(
+                [this]() {
+                    tick();
+                },
+                TICK_INTERVAL);
+        }
+    }
+
+    void TrafficStats::tick() {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(now - lastTick).count();
+        lastTick = now;
+
+        if (seconds > 0) {
+            const double alpha = 1 - std::exp(-seconds / RATE_TIME_CONSTANT);
+
+            topicMessages.tick(seconds, alpha);
+            topicBytes.tick(seconds, alpha);
+            clientMessages.tick(seconds, alpha);
+            clientBytes.tick(seconds, alpha);
+
+            messageRate += alpha * (static_cast<double>(pendingMessages) / seconds - messageRate);
+            byteRate += alpha * (static_cast<double>(pendingBytes) / seconds - byteRate);
+            pendingMessages = 0;
+            pendingBytes = 0;
+        }
+
+        for (const Receiver& receiver : receivers) {
+            const std::shared_ptr<express::Response> response = receiver.response.lock();
+
+            if (response != nullptr && response->isConnected()) {
+                const core::socket::stream::SocketConnection* socketConnection = response->getSocketContext()->getSocketConnection();
+
+                if (socketConnection->getTotalQueued() - socketConnection->getTotalSent() < RECEIVER_BACKLOG_LIMIT) {
+                    response->sendFragment("event:traffic-stats\r\ndata:" + top(receiver.n).dump() + "\r\n");
+                } else {
+                    VLOG(2) << "Traffic stats receiver " << receiver.id << " lagging, tick skipped";
+                }
+            }
+        }
+    }
+
+} // namespace mqtt::mqttbroker::lib
@@ -0,0 +1,152 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MQTTBROKER_LIB_TRAFFICSTATS_H
+#define MQTTBROKER_LIB_TRAFFICSTATS_H
+
+#include <core/timer/Timer.h>
+
+namespace express {
+    class Response;
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <nlohmann/json_fwd.hpp>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#endif
+
+namespace mqtt::mqttbroker::lib {
+
+    // Messages and payload bytes per topic and per client published by clients (not by the mapper). Each dimension is a bounded heavy
+    // hitters summary, so memory does not grow with the number of topics or clients. Rates are exponentially weighted per
+    // second averages, updated once a second.
+    class TrafficStats {
+    public:
+        // Space-Saving: at most capacity keys are counted. A new key replaces the key with the smallest count and inherits that
+        // count as its error, so count overestimates the true value by at most error.
+        class HeavyHitters {
+        public:
+            void setCapacity(std::size_t capacity);
+
+            void add(const std::string& key, std::uint64_t weight);
+            void tick(double seconds, double alpha);
+
+            nlohmann::json top(std::size_t n) const;
+
+        private:
+            struct Counter {
+                const std::string* key; // of index
+                std::uint64_t count = 0;
+                std::uint64_t error = 0;
+                std::uint64_t pending = 0; // since the last tick
+                double rate = 0;
+            };
+
+            std::size_t capacity = 0;
+
+            std::vector<Counter> counters;
+            std::unordered_map<std::string, std::size_t> index;
+            std::set<std::pair<std::uint64_t, std::size_t>> byCount;
+        };
+
+        TrafficStats(const TrafficStats&) = delete;
+        TrafficStats& operator=(const TrafficStats&) = delete;
+
+        static TrafficStats& instance();
+
+        void setCapacity(std::size_t capacity); // keys per summary, 0 disables the statistics
+
+        void record(const std::string& clientId, const std::string& topic, std::size_t bytes);
+
+        nlohmann::json top(std::size_t n) const;
+
+        // Sends a "traffic-stats" event every second. Ticks are skipped while the receiver has not drained the previous ones.
+        void addReceiver(const std::shared_ptr<express::Response>& response, std::size_t n);
+        std::size_t getReceiverCount() const;
+
+    private:
+        TrafficStats() = default;
+
+        struct Receiver {
+            std::uint64_t id;
+            std::weak_ptr<express::Response> response;
+            std::size_t n;
+        };
+
+        void start();
+        void tick();
+
+        std::size_t capacity = 0;
+
+        HeavyHitters topicMessages;
+        HeavyHitters topicBytes;
+        HeavyHitters clientMessages;
+        HeavyHitters clientBytes;
+
+        std::uint64_t messages = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t pendingMessages = 0;
+        std::uint64_t pendingBytes = 0;
+        double messageRate = 0;
+        double byteRate = 0;
+
+        std::list<Receiver> receivers;
+        std::uint64_t nextReceiverId = 0;
+
+        std::chrono::steady_clock::time_point lastTick;
+        core::timer::Timer tickTimer;
+        bool started = false;
+    };
+
+} // namespace mqtt::mqttbroker::lib
+
+#endif // MQTTBROKER_LIB_TRAFFICSTATS_H
@@ -41,9 +41,14 @@
 
 #include "SocketContextFactory.h" // IWYU pragma: keep
 #include "config.h"
+#include "lib/BrokerMetrics.h"
 #include "lib/ConfigApplication.h"
+#include "lib/LoopMonitor.h"
+#include "lib/MessageTap.h"
 #include "lib/Mqtt.h"
 #include "lib/MqttModel.h"
+#include "lib/SysTree.h"
+#include "lib/TrafficStats.h"
 
 #include <core/SNodeC.h>
 #include <utils/Config.h>
@@ -105,7 +110,11 @@
 //
 #include <log/Logger.h>
 //
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
 #include <utility>
+#include <vector>
 
 #endif
 
@@ -145,14 +154,61 @@ static void upgrade APPLICATION(req, res) {
     }
 }
 
+static mqtt::mqttbroker::lib::MqttModel::PageQuery getPageQuery(const std::shared_ptr<express::Request>& req) {
+    mqtt::mqttbroker::lib::MqttModel::PageQuery pageQuery;
+
+    pageQuery.cursor = req->query("cursor");
+    pageQuery.prefix = req->query("prefix");
+    pageQuery.filter = req->query("filter");
+    pageQuery.count = req->query("count") == "1" || req->query("count") == "true";
+    if (!req->query("limit").empty()) {
+        pageQuery.limit = std::clamp<std::size_t>(std::strtoul(req->query("limit").c_str(), nullptr, 10), 1, 1000);
+    }
+
+    return pageQuery;
+}
+
+static std::size_t getTopN(const std::shared_ptr<express::Request>& req) {
+    std::size_t n = 10;
+
+    if (!req->query("n").empty()) {
+        n = std::clamp<std::size_t>(std::strtoul(req->query("n").c_str(), nullptr, 10), 1, 1000);
+    }
+
+    return n;
+}
+
+static mqtt::mqttbroker::lib::MessageTap::Options getTapOptions(const std::shared_ptr<express::Request>& req) {
+    mqtt::mqttbroker::lib::MessageTap::Options options;
+
+    if (!req->query("filter").empty()) {
+        options.filter = req->query("filter");
+    }
+    if (!req->query("every").empty()) {
+        options.every = std::max<std::size_t>(std::strtoul(req->query("every").c_str(), nullptr, 10), 1);
+    } else if (!req->query("reservoir").empty()) {
+        options.reservoir = std::clamp<std::size_t>(std::strtoul(req->query("reservoir").c_str(), nullptr, 10), 1, 1000);
+    }
+    if (!req->query("max_payload").empty()) {
+        options.maxPayload = std::min<std::size_t>(std::strtoul(req->query("max_payload").c_str(), nullptr, 10), 65536);
+    }
+
+    return options;
+}
+
 static express::Router getRouter(std::shared_ptr<iot::mqtt::server::broker::Broker> broker, const std::string& webRoot) {
     const express::Router& jsonRouter = express::middleware::JsonMiddleware();
 
     /*
      * /api/mqtt/disconnect
-     * JSON.stringify({ clientId })
+     * JSON.stringify({ clientId }) or
+     * JSON.stringify({ selector: { username, address: <CIDR>, connected_before, connected_after: <Unix seconds> }, dry_run })
      */
-    jsonRouter.use("/api/mqtt", [] MIDDLEWARE(req, res, next) { // cppcheck-suppress unknownMacro
+    mqtt::lib::LatencyHistogram* adminTime = &mqtt::lib::LoopMonitor::instance().getSection("admin");
+
+    jsonRouter.use("/api/mqtt", [adminTime] MIDDLEWARE(req, res, next) { // cppcheck-suppress unknownMacro
+        const mqtt::lib::LoopMonitor::Timing timing(*adminTime);
+
         res->set({{"Access-Control-Allow-Origin", "*"},
                   {"Access-Control-Allow-Headers", "Content-Type"},
                   {"Access-Control-Allow-Methods", "GET, OPTIONS, POST"},
@@ -169,14 +225,44 @@ static express::Router getRouter(std::shared_ptr<iot::mqtt::server::broker::Brok
 
                 VLOG(1) << jsonString;
 
-                std::string clientId = json["clientId"].get<std::string>();
-                const mqtt::mqttbroker::lib::Mqtt* mqtt = mqtt::mqttbroker::lib::MqttModel::instance().getMqtt(clientId);
-
-                if (mqtt != nullptr) {
-                    mqtt->getMqttContext()->getSocketConnection()->close();
-                    res->send(R"({"success": true, "message": "Client disconnected successfully"})"_json.dump());
+                if (json.contains("selector")) {
+                    try {
+                        const bool dryRun = json.value("dry_run", false);
+
+                        // Selected first: closing a connection can remove the client from the registry
+                        const std::vector<mqtt::mqttbroker::lib::Mqtt*> selected =
+                            mqtt::mqttbroker::lib::MqttModel::instance().selectClients(
+                                mqtt::mqttbroker::lib::ClientRegistry::Selector::fromJson(json["selector"]));
+
+                        nlohmann::json clientIds = nlohmann::json::array();
+                        for (const mqtt::mqttbroker::lib::Mqtt* mqtt : selected) {
+                            clientIds.push_back(mqtt->getClientId());
+                        }
+                        if (!dryRun) {
+                            for (const mqtt::mqttbroker::lib::Mqtt* mqtt : selected) {
+                                mqtt->getMqttContext()->getSocketConnection()->close();
+                            }
+                        }
+
+                        VLOG(1) << (dryRun ? "Selected " : "Disconnecting ") << selected.size() << " clients";
+
+                        res->send(nlohmann::json({{"success", true},
+                                                  {dryRun ? "matched" : "disconnected", selected.size()},
+                                                  {"clients", clientIds}})
+                                      .dump());
+                    } catch (const std::invalid_argument& e) {
+                        res->status(400).send(nlohmann::json({{"success", false}, {"error", e.what()}}).dump());
+                    }
                 } else {
-                    res->status(404).send(R"({"success": false, "error": "Client not found"})"_json.dump());
+                    std::string clientId = json["clientId"].get<std::string>();
+                    const mqtt::mqttbroker::lib::Mqtt* mqtt = mqtt::mqttbroker::lib::MqttModel::instance().getMqtt(clientId);
+
+                    if (mqtt != nullptr) {
+                        mqtt->getMqttContext()->getSocketConnection()->close();
+                        res->send(R"({"success": true, "message": "Client disconnected successfully"})"_json.dump());
+                    } else {
+                        res->status(404).send(R"({"success": false, "error": "Client not found"})"_json.dump());
+                    }
                 }
             },
             [&res](const std::string& key) {
@@ -278,6 +364,55 @@ static express::Router getRouter(std::shared_ptr<iot::mqtt::server::broker::Brok
                 res->status(400).send("Attribute type not found: " + key);
             });
     });
+
+    /*
+     * /api/mqtt/clients, /api/mqtt/subscriptions, /api/mqtt/retained
+     * ?cursor=<next of the previous page>&limit=<1..1000>&prefix=<key prefix>&filter=<topic filter>&count=1
+     * { items: [...], count: <matching> | null, total: <all>, next: <cursor> | null }
+     * A page costs its own size; count=1 also counts all matches, a scan of the whole prefix range
+     */
+    jsonRouter.get("/api/mqtt/clients", [] APPLICATION(req, res) {
+        res->send(mqtt::mqttbroker::lib::MqttModel::instance().queryClients(getPageQuery(req)).dump());
+    });
+
+    jsonRouter.get("/api/mqtt/subscriptions", [broker] APPLICATION(req, res) {
+        res->send(mqtt::mqttbroker::lib::MqttModel::querySubscriptions(broker, getPageQuery(req)).dump());
+    });
+
+    jsonRouter.get("/api/mqtt/retained", [broker] APPLICATION(req, res) {
+        res->send(mqtt::mqttbroker::lib::MqttModel::queryRetained(broker, getPageQuery(req)).dump());
+    });
+
+    /*
+     * /api/mqtt/stats/top
+     * ?n=<1..1000, default 10>
+     * Heaviest topics and clients by messages and payload bytes, with counts, error bounds and per second rates
+     */
+    jsonRouter.get("/api/mqtt/stats/top", [] APPLICATION(req, res) {
+        res->send(mqtt::mqttbroker::lib::TrafficStats::instance().top(getTopN(req)).dump());
+    });
+
+    /*
+     * /api/mqtt/loop
+     * Event loop lag and wall time of onPublish and the admin handlers
+     */
+    jsonRouter.get("/api/mqtt/loop", [] APPLICATION(req, res) {
+        res->send(mqtt::lib::LoopMonitor::instance().toJson().dump());
+    });
+
+    jsonRouter.post("/api/mqtt/loop/reset", [] APPLICATION(req, res) {
+        mqtt::lib::LoopMonitor::instance().reset();
+
+        res->send(R"({"success": true, "message": "Loop monitor reset"})"_json.dump());
+    });
+
+    /*
+     * /api/mqtt/events/metrics
+     * Dashboard event receivers, their byte budget and what exceeding it cost
+     */
+    jsonRouter.get("/api/mqtt/events/metrics", [] APPLICATION(req, res) {
+        res->send(mqtt::mqttbroker::lib::MqttModel::instance().getEventReceiverMetrics().dump());
+    });
     const express::Router router;
 
     router.use(jsonRouter);
@@ -291,12 +426,59 @@ static express::Router getRouter(std::shared_ptr<iot::mqtt::server::broker::Brok
 
             res->sendHeader();
 
-            mqtt::mqttbroker::lib::MqttModel::instance().addEventReceiver(res, req->get("Last-Event-ID"), broker);
+            // ?snapshot=clients: subscriptions and retained messages are fetched page by page instead
+            mqtt::mqttbroker::lib::MqttModel::instance().addEventReceiver(
+                res, req->get("Last-Event-ID"), broker, req->query("snapshot") == "clients");
         } else {
             res->redirect("/clients");
         }
     });
 
+    router.get("/api/mqtt/stats/events", [] APPLICATION(req, res) {
+        if (web::http::ciContains(req->get("Accept"), "text/event-stream")) {
+            res->set({{"Content-Type", "text/event-stream"},
+                      {"Cache-Control", "no-cache"},
+                      {"Connection", "keep-alive"},
+                      {"Access-Control-Allow-Origin", "*"}});
+
+            res->sendHeader();
+
+            mqtt::mqttbroker::lib::TrafficStats::instance().addReceiver(res, getTopN(req));
+        } else {
+            res->status(406).send("Accept: text/event-stream required");
+        }
+    });
+
+    /*
+     * /api/mqtt/tap
+     * ?filter=<topic filter, default #>&every=<n> or &reservoir=<per second, default 20>&max_payload=<bytes, default 256>
+     * Sampled publishes as "message" events, a reservoir additionally sends a "sample" event with the counts of each second
+     */
+    router.get("/api/mqtt/tap", [] APPLICATION(req, res) {
+        if (web::http::ciContains(req->get("Accept"), "text/event-stream")) {
+            res->set({{"Content-Type", "text/event-stream"},
+                      {"Cache-Control", "no-cache"},
+                      {"Connection", "keep-alive"},
+                      {"Access-Control-Allow-Origin", "*"}});
+
+            res->sendHeader();
+
+            mqtt::mqttbroker::lib::MessageTap::instance().addTap(res, getTapOptions(req));
+        } else {
+            res->status(406).send("Accept: text/event-stream required");
+        }
+    });
+
+    /*
+     * /metrics
+     * Prometheus text exposition of the broker, the mapper and the dashboard streams
+     */
+    router.get("/metrics", [broker] APPLICATION(req, res) {
+        res->set("Content-Type", "text/plain; version=0.0.4; charset=utf-8")
+            .send(mqtt::mqttbroker::lib::BrokerMetrics::instance().toPrometheus(
+                broker, utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getMqttMapper()));
+    });
+
     router.get("/ws", [] APPLICATION(req, res) {
         if (req->headers.contains("upgrade")) {
             upgrade(req, res);
@@ -374,6 +556,30 @@ int main(int argc, char* argv[]) {
     std::shared_ptr<iot::mqtt::server::broker::Broker> broker = iot::mqtt::server::broker::Broker::instance(
         SUBSCRIPTION_MAX_QOS, utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getSessionStore());
 
+    mqtt::mqttbroker::lib::MqttModel::instance().setEventLogLevel(
+        utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getEventLogLevel());
+    mqtt::mqttbroker::lib::MqttModel::instance().setEventBatchWindow(
+        utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getEventBatchWindow());
+    mqtt::mqttbroker::lib::MqttModel::instance().setEventReceiverBudget(
+        utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getEventReceiverBudget(),
+        mqtt::mqttbroker::lib::MqttModel::parseOverflowPolicy(
+            utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getEventReceiverOverflow()));
+    mqtt::mqttbroker::lib::MqttModel::instance().setEventReplaySize(
+        utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getEventReplaySize());
+    mqtt::mqttbroker::lib::TrafficStats::instance().setCapacity(
+        utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getTrafficStatsCapacity());
+
+    mqtt::lib::LoopMonitor::instance().start("broker",
+                                             utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getLoopReport());
+    mqtt::lib::LoopMonitor::instance().addReporter(broker.get(), [broker](const std::string& topic, const std::string& message) {
+        broker->publish("", topic, message, 0, true);
+    });
+
+    mqtt::mqttbroker::lib::SysTree::instance().start(
+        broker,
+        utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getMqttMapper(),
+        utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttBroker>()->getSysInterval());
+
 #ifdef CONFIG_MQTTSUITE_BROKER_TCP_IPV4
     net::in::stream::legacy::Server<mqtt::mqttbroker::SocketContextFactory>( //
         "in-mqtt",
@@ -74,6 +74,7 @@ namespace mqtt::mqttcli {
                                                                            configSession->getUsername(),
                                                                            configSession->getPassword(),
                                                                            configSubscribe->getTopic(),
+                                                                           configSubscribe->getLoopReport(),
                                                                            configPublish->getTopic(),
                                                                            configPublish->getMessage(),
                                                                            configPublish->getRetain()));
@@ -50,7 +50,14 @@ namespace mqtt::mqttcli::lib {
         : utils::SubCommand(parent, this, "Applications (at least one required)")
         , topicOpt( //
               setConfigurable(addOption("--topic", "List of topics subscribing to", "string", CLI::TypeValidator<std::string>()), true)
-                  ->take_all()) {
+                  ->take_all())
+        , loopReportOpt( //
+              setConfigurable(addFlag("--loop-report{true}",
+                                      "Publish the event loop statistics to $SYS/mqttsuite/cli/loop every 10 s",
+                                      "bool",
+                                      "false",
+                                      CLI::IsMember({"true", "false"})),
+                              true)) {
         required(topicOpt);
 
         forceUnrequired(true);
@@ -74,6 +81,16 @@ namespace mqtt::mqttcli::lib {
         return *this;
     }
 
+    bool ConfigSubscribe::getLoopReport() const {
+        return loopReportOpt->as<bool>();
+    }
+
+    const ConfigSubscribe& ConfigSubscribe::setLoopReport(bool loopReport) {
+        loopReportOpt->default_val(loopReport);
+
+        return *this;
+    }
+
     ConfigPublish::ConfigPublish(utils::SubCommand* parent)
         : utils::SubCommand(parent, this, "Applications (at least one required)")
         , topicOpt( //
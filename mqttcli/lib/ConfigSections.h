@@ -67,8 +67,12 @@ namespace mqtt::mqttcli::lib {
 
         const ConfigSubscribe& setTopic(const std::string& topic);
 
+        bool getLoopReport() const;
+        const ConfigSubscribe& setLoopReport(bool loopReport);
+
     private:
         CLI::Option* topicOpt;
+        CLI::Option* loopReportOpt;
     };
 
     class ConfigPublish : public utils::SubCommand {
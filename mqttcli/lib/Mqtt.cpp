@@ -41,6 +41,8 @@
 
 #include "Mqtt.h"
 
+#include "lib/LoopMonitor.h"
+
 #include <iot/mqtt/Topic.h>
 #include <iot/mqtt/packets/Connack.h>
 #include <iot/mqtt/packets/Publish.h>
@@ -226,6 +228,7 @@ namespace mqtt::mqttcli::lib {
                const std::string& username,
                const std::string& password,
                const std::list<std::string>& subTopics,
+               bool loopReport,
                const std::string& pubTopic,
                const std::string& pubMessage,
                bool pubRetain,
@@ -240,6 +243,7 @@ namespace mqtt::mqttcli::lib {
         , username(username)
         , password(password)
         , subTopics(subTopics)
+        , loopReport(loopReport)
         , pubTopic(pubTopic)
         , pubMessage(pubMessage)
         , pubRetain(pubRetain) {
@@ -260,6 +264,10 @@ namespace mqtt::mqttcli::lib {
         sendConnect(cleanSession, willTopic, willMessage, willQoS, willRetain, username, password);
     }
 
+    void Mqtt::onDisconnected() {
+        mqtt::lib::LoopMonitor::instance().removeReporter(this);
+    }
+
     bool Mqtt::onSignal(int signum) {
         VLOG(1) << "MQTT: On Exit due to '" << strsignal(signum) << "' (SIG" << utils::system::sigabbrev_np(signum) << " = " << signum
                 << ")";
@@ -312,6 +320,13 @@ namespace mqtt::mqttcli::lib {
                                    });
                     sendSubscribe(topicList);
 
+                    // Only a subscribing session lives long enough to report
+                    if (loopReport) {
+                        mqtt::lib::LoopMonitor::instance().addReporter(this, [this](const std::string& topic, const std::string& message) {
+                            sendPublish(topic, message, 0, false);
+                        });
+                    }
+
                     sendDisconnectFlag = false;
                 } catch (const std::logic_error&) {
                 }
@@ -360,6 +375,9 @@ namespace mqtt::mqttcli::lib {
     }
 
     void Mqtt::onPublish(const iot::mqtt::packets::Publish& publish) {
+        static mqtt::lib::LatencyHistogram& onPublishTime = mqtt::lib::LoopMonitor::instance().getSection("onPublish");
+        const mqtt::lib::LoopMonitor::Timing timing(onPublishTime);
+
         std::string prefix = "MQTT Publish";
         std::string headLine = publish.getTopic() + " │ QoS: " + std::to_string(static_cast<uint16_t>(publish.getQoS())) +
                                " │ Retain: " + (publish.getRetain() != 0 ? "true" : "false") +
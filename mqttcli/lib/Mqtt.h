@@ -68,6 +68,7 @@ namespace mqtt::mqttcli::lib {
                       const std::string& username,
                       const std::string& password,
                       const std::list<std::string>& subTopics,
+                      bool loopReport, // publish the event loop statistics while subscribed
                       const std::string& pubTopic,
                       const std::string& pubMessage,
                       bool pubRetain = false,
@@ -77,6 +78,7 @@ namespace mqtt::mqttcli::lib {
         using Super = iot::mqtt::client::Mqtt;
 
         void onConnected() final;
+        void onDisconnected() final;
         [[nodiscard]] bool onSignal(int signum) final;
 
         void onPublish(const iot::mqtt::packets::Publish& publish) final;
@@ -96,6 +98,7 @@ namespace mqtt::mqttcli::lib {
         const std::string password;
 
         const std::list<std::string> subTopics;
+        const bool loopReport;
         const std::string pubTopic;
         const std::string pubMessage;
         const bool pubRetain;
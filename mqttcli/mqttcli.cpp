@@ -42,6 +42,7 @@
 #include "SocketContextFactory.h"
 #include "config.h"
 #include "lib/ConfigSections.h"
+#include "lib/LoopMonitor.h"
 
 #ifdef LINK_SUBPROTOCOL_STATIC
 
@@ -242,6 +243,8 @@ static void createWSConfig(net::config::ConfigInstance* config) {
 int main(int argc, char* argv[]) {
     core::SNodeC::init(argc, argv);
 
+    mqtt::lib::LoopMonitor::instance().start("cli");
+
 #if defined(CONFIG_MQTTSUITE_CLI_TCP_IPV4)
     startClient<net::in::stream::legacy::SocketClient>( //
         "in-mqtt",
@@ -83,6 +83,7 @@ namespace mqtt::mqttcli::websocket {
                                            configSession->getUsername(),
                                            configSession->getPassword(),
                                            configSubscribe->getTopic(),
+                                           configSubscribe->getLoopReport(),
                                            configPublish->getTopic(),
                                            configPublish->getMessage(),
                                            configPublish->getRetain()));
@@ -59,9 +59,18 @@ namespace mqtt::mqttintegrator {
     core::socket::stream::SocketContext* SocketContextFactory::create(core::socket::stream::SocketConnection* socketConnection) {
         mqtt::lib::ConfigMqttIntegrator* config = utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttIntegrator>();
 
-        return new iot::mqtt::SocketContext(
-            socketConnection,
-            new mqtt::mqttintegrator::lib::Mqtt(socketConnection->getConnectionName(), config->getMqttMapper(), config->getSessionStore()));
+        const mqtt::mqttintegrator::lib::Mqtt::OutboundOptions outboundOptions{
+            config->getInflightWindow(),
+            config->getSendQueue(),
+            mqtt::mqttintegrator::lib::Mqtt::OutboundOptions::parseOverflowPolicy(config->getOverflowPolicy())};
+
+        return new iot::mqtt::SocketContext(socketConnection,
+                                            new mqtt::mqttintegrator::lib::Mqtt(socketConnection->getConnectionName(), //
+                                                                                socketConnection->getInstanceName(),
+                                                                                config->getMappingNamespaces(),
+                                                                                config->getSessionStore(),
+                                                                                config->getShards(),
+                                                                                outboundOptions));
     }
 
 } // namespace mqtt::mqttintegrator
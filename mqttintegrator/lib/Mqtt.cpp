@@ -43,7 +43,10 @@
 
 #include "Mqtt.h"
 
+#include "Outbox.h"
+#include "lib/LoopMonitor.h"
 #include "lib/MappingAdminRouter.h"
+#include "lib/MappingNamespace.h"
 #include "lib/MqttMapper.h"
 
 #include <iot/mqtt/Topic.h>
@@ -52,8 +55,13 @@
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
+#include "log/Logger.h"
+
 #include <algorithm>
 #include <functional>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <tuple>
 
 #endif
 
@@ -61,28 +69,213 @@ namespace mqtt::mqttintegrator::lib {
 
     std::set<Mqtt*> Mqtt::mqttInstances;
 
+    std::shared_ptr<Outbox> Mqtt::outbox;
+    std::size_t Mqtt::outboxDrainRate = 0;
+    Mqtt* Mqtt::outboxDrainer = nullptr;
+
+    static std::string shardSuffixed(const std::string& name, std::size_t shards, std::size_t shard) {
+        return (shards > 1 || shard > 0) && !name.empty() ? name + "-" + std::to_string(shard) : name;
+    }
+
     struct Mqtt::ScheduledPublish {
         utils::Timeval when = 0;
         std::size_t seq = 0;
-        iot::mqtt::packets::Publish publish;
+        std::shared_ptr<const iot::mqtt::packets::Publish> publish;
         utils::Timeval delay;
+        std::size_t topicHash = 0;
+        std::shared_ptr<mqtt::lib::CoalescedPublish> coalescedPublish; // the latest value and its topicHash are taken when due
     };
 
     Mqtt::Mqtt(const std::string& connectionName,
-               std::shared_ptr<mqtt::lib::MqttMapper> mqttMapper,
-               const std::string& sessionStoreFileName)
-        : iot::mqtt::client::Mqtt(connectionName, //
-                                  mqttMapper->getClientId(),
-                                  mqttMapper->getKeepAlive(),
-                                  sessionStoreFileName)
-        , mqttMapper(mqttMapper)
-        , currentSubscriptions(mqttMapper->extractSubscriptions())
-        , delayedQueue(this) {
+               const std::string& instanceName,
+               std::shared_ptr<mqtt::lib::MappingNamespaces> mappingNamespaces,
+               const std::string& sessionStoreFileName,
+               std::size_t shards,
+               const OutboundOptions& outboundOptions)
+        : Mqtt(connectionName,
+               instanceName,
+               mappingNamespaces,
+               sessionStoreFileName,
+               std::max<std::size_t>(shards, 1),
+               outboundOptions,
+               acquireShard(instanceName, std::max<std::size_t>(shards, 1))) {
+    }
+
+    Mqtt::Mqtt(const std::string& connectionName,
+               const std::string& instanceName,
+               std::shared_ptr<mqtt::lib::MappingNamespaces> mappingNamespaces,
+               const std::string& sessionStoreFileName,
+               std::size_t shards,
+               const OutboundOptions& outboundOptions,
+               std::size_t shard)
+        : iot::mqtt::client::Mqtt(connectionName, // Each shard needs its own client-id and session
+                                  shardSuffixed(mappingNamespaces->getDefault()->getMqttMapper()->getClientId(), shards, shard),
+                                  mappingNamespaces->getDefault()->getMqttMapper()->getKeepAlive(),
+                                  shardSuffixed(sessionStoreFileName, shards, shard))
+        , instanceName(instanceName)
+        , shards(shards)
+        , shard(shard)
+        , mappingNamespaces(mappingNamespaces)
+        , currentSubscriptions(extractShardSubscriptions())
+        , delayedQueue(this)
+        , outboundQueue(this, outboundOptions) {
         mqttInstances.insert(this);
+
+        if (shard >= shards) {
+            LOG(ERROR) << connectionName << ": All " << shards << " shards of instance '" << instanceName
+                       << "' are taken. This connection subscribes to nothing";
+        } else if (shards > 1) {
+            VLOG(1) << connectionName << ": Shard " << shard << " of " << shards;
+        }
     }
 
     Mqtt::~Mqtt() {
+        connected = false;
         mqttInstances.erase(this);
+        mqtt::lib::LoopMonitor::instance().removeReporter(this);
+
+        spillToOutbox();
+    }
+
+    void Mqtt::setOutbox(std::shared_ptr<Outbox> outbox, std::size_t drainRate) {
+        Mqtt::outbox = std::move(outbox);
+        Mqtt::outboxDrainRate = drainRate;
+    }
+
+    void Mqtt::spillToOutbox() {
+        if (outbox) {
+            std::size_t spilled = 0;
+
+            // Delayed publishes are kept without their remaining delay: they are due at the latest when the connection is back
+            for (; !delayedQueue.empty(); delayedQueue.pop()) {
+                std::shared_ptr<const iot::mqtt::packets::Publish> delayedPublish = delayedQueue.top().publish;
+                if (delayedQueue.top().coalescedPublish != nullptr) {
+                    delayedPublish = delayedQueue.top().coalescedPublish->take().first;
+                }
+
+                if (delayedPublish->getQoS() > 0) {
+                    spilled += outbox->push(*delayedPublish) ? 1 : 0;
+                }
+            }
+            delayedQueue.cancel();
+
+            for (const std::shared_ptr<const iot::mqtt::packets::Publish>& publish : outboundQueue.takeQueued()) {
+                if (publish->getQoS() > 0) {
+                    spilled += outbox->push(*publish) ? 1 : 0;
+                }
+            }
+
+            if (spilled > 0) {
+                VLOG(1) << getConnectionName() << ": " << spilled << " publishes spilled to the outbox";
+            }
+        }
+
+        if (outboxDrainer == this) {
+            outboxDrainTimer.cancel();
+            outboxDrainer = nullptr;
+
+            const auto it = std::find_if(mqttInstances.begin(), mqttInstances.end(), [](const Mqtt* mqtt) {
+                return mqtt->connected;
+            });
+            if (it != mqttInstances.end()) {
+                (*it)->startOutboxDrain();
+            }
+        }
+    }
+
+    void Mqtt::startOutboxDrain() {
+        if (outbox && !outbox->empty() && outboxDrainer == nullptr) {
+            VLOG(1) << getConnectionName() << ": Draining " << outbox->size() << " publishes from the outbox";
+
+            outboxDrainer = this;
+            drainOutbox();
+        }
+    }
+
+    void Mqtt::drainOutbox() {
+        // One batch every 100ms so that a long outage is not replayed as a burst
+        const std::size_t batchSize = std::max<std::size_t>(1, outboxDrainRate / 10);
+
+        // A publish stays in the outbox until its connection can send it: handed to a full send queue it could be dropped
+        for (std::size_t drained = 0; drained < batchSize && !outbox->empty(); ++drained) {
+            const std::shared_ptr<const iot::mqtt::packets::Publish> publish = outbox->front();
+            if (publish == nullptr) {
+                break;
+            }
+
+            Mqtt* owner = getShardOwner(std::hash<std::string>{}(publish->getTopic()));
+            if (!owner->connected || !owner->outboundQueue.isReady(publish->getQoS())) {
+                break;
+            }
+
+            outbox->pop();
+            owner->outboundQueue.publish(publish);
+        }
+
+        if (outbox->empty()) {
+            outboxDrainer = nullptr;
+        } else {
+            outboxDrainTimer = core::timer::Timer::singleshotTimer(
+                [this]() {
+                    drainOutbox();
+                },
+                0.1);
+        }
+    }
+
+    std::size_t Mqtt::acquireShard(const std::string& instanceName, std::size_t shards) {
+        std::size_t shard = 0;
+
+        const auto isTaken = [&instanceName, &shard](const Mqtt* mqtt) {
+            return mqtt->instanceName == instanceName && mqtt->shard == shard;
+        };
+
+        // Reconnecting connections take over the shard of the connection they replace
+        while (shard < shards && std::any_of(mqttInstances.begin(), mqttInstances.end(), isTaken)) {
+            ++shard;
+        }
+
+        return shard;
+    }
+
+    std::size_t Mqtt::shardOf(std::size_t topicHash) const {
+        return shards > 1 ? topicHash % shards : 0;
+    }
+
+    std::list<iot::mqtt::Topic> Mqtt::extractShardSubscriptions() const {
+        std::list<iot::mqtt::Topic> subscriptions;
+
+        if (shard < shards) {
+            subscriptions = mappingNamespaces->extractSubscriptions();
+        }
+
+        if (shards > 1) {
+            subscriptions.remove_if([this](const iot::mqtt::Topic& topic) {
+                return shardOf(std::hash<std::string>{}(topic.getName())) != shard;
+            });
+        }
+
+        return subscriptions;
+    }
+
+    Mqtt* Mqtt::getShardOwner(std::size_t topicHash) {
+        Mqtt* owner = this;
+
+        if (shards > 1) {
+            const std::size_t ownerShard = shardOf(topicHash);
+
+            if (ownerShard != shard) {
+                const auto it = std::find_if(mqttInstances.begin(), mqttInstances.end(), [this, ownerShard](const Mqtt* mqtt) {
+                    return mqtt->instanceName == instanceName && mqtt->shard == ownerShard && mqtt->connected;
+                });
+
+                if (it != mqttInstances.end()) {
+                    owner = *it;
+                }
+            }
+        }
+
+        return owner;
     }
 
     mqtt::lib::admin::ReloadResult Mqtt::updateSubscriptions(bool mustReconnect) {
@@ -116,7 +309,7 @@ namespace mqtt::mqttintegrator::lib {
                      WillQoS,
                      willRetain,
                      username,
-                     password] = mqttMapper->getConnectPayload();
+                     password] = mappingNamespaces->getDefault()->getMqttMapper()->getConnectPayload();
 
         sendConnect(cleanSession, willTopic, willMessage, WillQoS, willRetain, username, password);
     }
@@ -127,28 +320,88 @@ namespace mqtt::mqttintegrator::lib {
     }
 
     void Mqtt::onConnack(const iot::mqtt::packets::Connack& connack) {
-        if (connack.getReturnCode() == 0 && !connack.getSessionPresent()) {
+        connected = connack.getReturnCode() == 0;
+
+        if (connected && !connack.getSessionPresent() && !currentSubscriptions.empty()) {
             sendSubscribe(currentSubscriptions);
         }
+
+        if (connected) {
+            mqtt::lib::LoopMonitor::instance().addReporter(this, [this](const std::string& topic, const std::string& message) {
+                sendPublish(topic, message, 0, false);
+            });
+
+            startOutboxDrain();
+        }
     }
 
     void Mqtt::onPublish(const iot::mqtt::packets::Publish& publish) {
-        const auto& [immediatePublishes, scheduledPublishes] = mqttMapper->getMappings(publish);
+        static mqtt::lib::LatencyHistogram& onPublishTime = mqtt::lib::LoopMonitor::instance().getSection("onPublish");
+        const mqtt::lib::LoopMonitor::Timing timing(onPublishTime);
+
+        for (mqtt::lib::MappingNamespace* mappingNamespace : mappingNamespaces->match(publish.getTopic())) {
+            mappingNamespace->getMqttMapper()->getMappings(
+                publish, [this, weakAlive = std::weak_ptr<bool>(alive)](mqtt::lib::MqttMapper::MappedPublishes&& mappedPublishes) {
+                    if (!weakAlive.expired()) {
+                        auto& [immediatePublishes, scheduledPublishes] = mappedPublishes;
+
+                        for (mqtt::lib::MqttMapper::ScheduledPublish& delayedPublish : scheduledPublishes) {
+                            delayedQueue.delayPublish(delayedPublish.delay,
+                                                      std::move(delayedPublish.publish),
+                                                      delayedPublish.topicHash,
+                                                      std::move(delayedPublish.coalescedPublish));
+                        }
+
+                        for (const mqtt::lib::MqttMapper::MappedPublish& immediatePublish : immediatePublishes) {
+                            getShardOwner(immediatePublish.topicHash)->outboundQueue.publish(immediatePublish.publish);
+
+                            onPublish(immediatePublish.publish);
+                        }
+                    }
+                });
+        }
+    }
+
+    void Mqtt::onPuback([[maybe_unused]] const iot::mqtt::packets::Puback& puback) {
+        outboundQueue.acknowledged();
+    }
+
+    void Mqtt::onPubcomp([[maybe_unused]] const iot::mqtt::packets::Pubcomp& pubcomp) {
+        outboundQueue.acknowledged();
+    }
+
+    nlohmann::json Mqtt::getOutboundMetrics() {
+        nlohmann::json connections = nlohmann::json::array();
+
+        for (const Mqtt* mqtt : mqttInstances) {
+            nlohmann::json metrics = mqtt->outboundQueue.getMetrics();
+            metrics["connection"] = mqtt->getConnectionName();
+            metrics["shard"] = mqtt->shard;
+
+            connections.push_back(std::move(metrics));
+        }
 
-        for (const mqtt::lib::MqttMapper::ScheduledPublish& delayedPublish : scheduledPublishes) {
-            delayedQueue.delayPublish(delayedPublish.delay, delayedPublish.publish);
+        nlohmann::json outboundMetrics = {{"connections", connections}};
+        if (outbox) {
+            outboundMetrics["outbox"] = outbox->getMetrics();
+            outboundMetrics["outbox"]["draining"] = outboxDrainer != nullptr;
         }
 
-        for (const iot::mqtt::packets::Publish& immediatePublish : immediatePublishes) {
-            sendPublish(
-                immediatePublish.getTopic(), immediatePublish.getMessage(), immediatePublish.getQoS(), immediatePublish.getRetain());
+        return outboundMetrics;
+    }
+
+    Mqtt::OverflowPolicy Mqtt::OutboundOptions::parseOverflowPolicy(const std::string& overflowPolicy) {
+        OverflowPolicy policy = OverflowPolicy::DROP_OLDEST;
 
-            onPublish(immediatePublish);
+        if (overflowPolicy == "drop-new") {
+            policy = OverflowPolicy::DROP_NEW;
         }
+
+        return policy;
     }
 
     std::pair<std::size_t, std::size_t> Mqtt::resubscribe() {
-        std::list<iot::mqtt::Topic> newSubscriptions = mqttMapper->extractSubscriptions();
+        std::list<iot::mqtt::Topic> newSubscriptions = extractShardSubscriptions();
 
         std::list<std::string> topicsToUnsubscribe;
         for (const auto& currentTopic : currentSubscriptions) {
@@ -205,12 +458,16 @@ namespace mqtt::mqttintegrator::lib {
         const auto now = utils::Timeval::currentTime();
 
         while (!empty() && top().when <= now) {
-            const iot::mqtt::packets::Publish duePublish = top().publish;
+            std::shared_ptr<const iot::mqtt::packets::Publish> duePublish = top().publish;
+            std::size_t topicHash = top().topicHash;
+            if (top().coalescedPublish != nullptr) {
+                std::tie(duePublish, topicHash) = top().coalescedPublish->take();
+            }
             pop();
 
-            mqtt->sendPublish(duePublish.getTopic(), duePublish.getMessage(), duePublish.getQoS(), duePublish.getRetain());
+            mqtt->getShardOwner(topicHash)->outboundQueue.publish(duePublish);
 
-            mqtt->onPublish(duePublish);
+            mqtt->onPublish(*duePublish);
         }
     }
 
@@ -233,8 +490,12 @@ namespace mqtt::mqttintegrator::lib {
             delay);
     }
 
-    void Mqtt::DelayedQueue::delayPublish(const utils::Timeval& delay, const iot::mqtt::packets::Publish& publish) {
-        minHeap.emplace(utils::Timeval::currentTime() + delay, nextSeq++, publish, delay);
+    void Mqtt::DelayedQueue::delayPublish(const utils::Timeval& delay,
+                                          std::shared_ptr<const iot::mqtt::packets::Publish> publish,
+                                          std::size_t topicHash,
+                                          std::shared_ptr<mqtt::lib::CoalescedPublish> coalescedPublish) {
+        minHeap.emplace(
+            utils::Timeval::currentTime() + delay, nextSeq++, std::move(publish), delay, topicHash, std::move(coalescedPublish));
         armDelayTimer();
     }
 
@@ -250,4 +511,103 @@ namespace mqtt::mqttintegrator::lib {
         minHeap.pop();
     }
 
+    void Mqtt::DelayedQueue::cancel() {
+        delayTimer.cancel();
+    }
+
+    Mqtt::OutboundQueue::OutboundQueue(Mqtt* mqtt, const OutboundOptions& outboundOptions)
+        : mqtt(mqtt)
+        , outboundOptions(outboundOptions) {
+    }
+
+    bool Mqtt::OutboundQueue::mayPass(uint8_t qoS) const {
+        return qoS == 0 || outboundOptions.inflightWindow == 0 || inflight < outboundOptions.inflightWindow;
+    }
+
+    bool Mqtt::OutboundQueue::isReady(uint8_t qoS) const {
+        return queue.empty() && mayPass(qoS);
+    }
+
+    std::deque<std::shared_ptr<const iot::mqtt::packets::Publish>> Mqtt::OutboundQueue::takeQueued() {
+        return std::exchange(queue, {});
+    }
+
+    void Mqtt::OutboundQueue::publish(const iot::mqtt::packets::Publish& publish) {
+        if (!mqtt->connected && publish.getQoS() > 0 && outbox) {
+            outbox->push(publish);
+        } else if (queue.empty() && mayPass(publish.getQoS())) {
+            send(publish);
+        } else {
+            enqueue(std::make_shared<const iot::mqtt::packets::Publish>(publish));
+        }
+    }
+
+    void Mqtt::OutboundQueue::publish(std::shared_ptr<const iot::mqtt::packets::Publish> publish) {
+        if (!mqtt->connected && publish->getQoS() > 0 && outbox) {
+            outbox->push(*publish);
+        } else if (queue.empty() && mayPass(publish->getQoS())) {
+            send(*publish);
+        } else {
+            enqueue(std::move(publish));
+        }
+    }
+
+    void Mqtt::OutboundQueue::send(const iot::mqtt::packets::Publish& publish) {
+        mqtt->sendPublish(publish.getTopic(), publish.getMessage(), publish.getQoS(), publish.getRetain());
+
+        if (publish.getQoS() > 0) {
+            ++inflight;
+        }
+        ++sent;
+    }
+
+    void Mqtt::OutboundQueue::enqueue(std::shared_ptr<const iot::mqtt::packets::Publish> publish) {
+        if (outboundOptions.queueCapacity > 0 && queue.size() >= outboundOptions.queueCapacity) {
+            switch (outboundOptions.overflowPolicy) {
+                case OverflowPolicy::DROP_NEW:
+                    ++dropped;
+                    publish.reset();
+                    break;
+                case OverflowPolicy::DROP_OLDEST:
+                    ++dropped;
+                    queue.pop_front();
+                    break;
+            }
+        }
+
+        if (publish) {
+            queue.push_back(std::move(publish));
+            maxQueued = std::max(maxQueued, queue.size());
+        }
+    }
+
+    void Mqtt::OutboundQueue::drain() {
+        while (!queue.empty() && mayPass(queue.front()->getQoS())) {
+            const std::shared_ptr<const iot::mqtt::packets::Publish> publish = std::move(queue.front());
+            queue.pop_front();
+
+            send(*publish);
+        }
+    }
+
+    void Mqtt::OutboundQueue::acknowledged() {
+        if (inflight > 0) {
+            --inflight;
+        }
+        ++acked;
+
+        drain();
+    }
+
+    nlohmann::json Mqtt::OutboundQueue::getMetrics() const {
+        return {{"inflight", inflight},
+                {"inflight_window", outboundOptions.inflightWindow},
+                {"queued", queue.size()},
+                {"queued_max", maxQueued},
+                {"queue_capacity", outboundOptions.queueCapacity},
+                {"sent", sent},
+                {"acked", acked},
+                {"dropped", dropped}};
+    }
+
 } // namespace mqtt::mqttintegrator::lib
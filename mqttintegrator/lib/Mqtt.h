@@ -47,7 +47,8 @@
 #include <iot/mqtt/client/Mqtt.h>
 
 namespace mqtt::lib {
-    class MqttMapper;
+    class CoalescedPublish;
+    class MappingNamespaces;
     namespace admin {
         struct ReloadResult;
     }
@@ -63,8 +64,11 @@ namespace iot::mqtt {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <list>
 #include <memory>
+#include <nlohmann/json_fwd.hpp>
 #include <queue>
 #include <set>
 #include <string>
@@ -75,18 +79,48 @@ namespace iot::mqtt {
 
 namespace mqtt::mqttintegrator::lib {
 
+    class Outbox;
+
     class Mqtt : public iot::mqtt::client::Mqtt {
     public:
+        enum class OverflowPolicy { DROP_OLDEST, DROP_NEW };
+
+        struct OutboundOptions {
+            std::size_t inflightWindow = 0; // maximum of unacknowledged QoS 1/2 publishes, 0: unlimited
+            std::size_t queueCapacity = 0;  // publishes waiting for a free inflight slot before the overflow policy applies
+            OverflowPolicy overflowPolicy = OverflowPolicy::DROP_OLDEST;
+
+            static OverflowPolicy parseOverflowPolicy(const std::string& overflowPolicy); // drop-oldest or drop-new
+        };
+
         explicit Mqtt(const std::string& connectionName,
-                      std::shared_ptr<mqtt::lib::MqttMapper> mqttMapper,
-                      const std::string& sessionStoreFileName);
+                      const std::string& instanceName, // the shards of one client instance are counted apart from other instances
+                      std::shared_ptr<mqtt::lib::MappingNamespaces> mappingNamespaces,
+                      const std::string& sessionStoreFileName,
+                      std::size_t shards,
+                      const OutboundOptions& outboundOptions);
 
         ~Mqtt() override;
         static mqtt::lib::admin::ReloadResult updateSubscriptions(bool mustReconnect);
+        static nlohmann::json getOutboundMetrics();
+
+        // QoS 1/2 publishes produced while no connection is up are kept in the outbox and drained after the next CONNACK
+        static void setOutbox(std::shared_ptr<Outbox> outbox, std::size_t drainRate); // drainRate: publishes per second
 
     private:
         using Super = iot::mqtt::client::Mqtt;
 
+        Mqtt(const std::string& connectionName,
+             const std::string& instanceName,
+             std::shared_ptr<mqtt::lib::MappingNamespaces> mappingNamespaces,
+             const std::string& sessionStoreFileName,
+             std::size_t shards,
+             const OutboundOptions& outboundOptions,
+             std::size_t shard);
+
+        // The lowest shard not taken by another connection of the instance, shards if all are taken (surplus connection)
+        static std::size_t acquireShard(const std::string& instanceName, std::size_t shards);
+
         struct ScheduledPublish;
 
         void onConnected() final;
@@ -94,10 +128,25 @@ namespace mqtt::mqttintegrator::lib {
 
         void onConnack(const iot::mqtt::packets::Connack& connack) final;
         void onPublish(const iot::mqtt::packets::Publish& publish) final;
+        void onPuback(const iot::mqtt::packets::Puback& puback) final;
+        void onPubcomp(const iot::mqtt::packets::Pubcomp& pubcomp) final;
 
         std::pair<std::size_t, std::size_t> resubscribe();
 
-        std::shared_ptr<mqtt::lib::MqttMapper> mqttMapper;
+        void startOutboxDrain();
+        void drainOutbox();
+        void spillToOutbox();
+
+        std::list<iot::mqtt::Topic> extractShardSubscriptions() const;
+        std::size_t shardOf(std::size_t topicHash) const; // topicHash is the std::hash of the topic
+        Mqtt* getShardOwner(std::size_t topicHash);
+
+        std::string instanceName;
+        std::size_t shards;
+        std::size_t shard; // shards for a surplus connection, which subscribes to nothing
+        bool connected = false;
+
+        std::shared_ptr<mqtt::lib::MappingNamespaces> mappingNamespaces;
         std::list<iot::mqtt::Topic> currentSubscriptions;
 
         class DelayedQueue {
@@ -110,12 +159,17 @@ namespace mqtt::mqttintegrator::lib {
             explicit DelayedQueue(Mqtt* mqtt);
             ~DelayedQueue();
 
-            void delayPublish(const utils::Timeval& delay, const iot::mqtt::packets::Publish& publish);
+            void delayPublish(const utils::Timeval& delay,
+                              std::shared_ptr<const iot::mqtt::packets::Publish> publish,
+                              std::size_t topicHash,
+                              std::shared_ptr<mqtt::lib::CoalescedPublish> coalescedPublish);
 
             bool empty() const;
             ScheduledPublish const& top() const;
             void pop();
 
+            void cancel();
+
         private:
             Mqtt* mqtt;
             std::size_t nextSeq = 0;
@@ -126,7 +180,49 @@ namespace mqtt::mqttintegrator::lib {
             void armDelayTimer();
         } delayedQueue;
 
+        // Limits the number of unacknowledged QoS 1/2 publishes. Publishes exceeding the window wait in a queue, in order with
+        // QoS 0 publishes sent meanwhile, and are released by PUBACK/PUBCOMP. A full queue drops a
+        // publish: the event loop can not block.
+        class OutboundQueue {
+        public:
+            OutboundQueue(Mqtt* mqtt, const OutboundOptions& outboundOptions);
+
+            std::deque<std::shared_ptr<const iot::mqtt::packets::Publish>> takeQueued();
+
+            bool isReady(uint8_t qoS) const; // a publish would be sent right away instead of being queued
+
+            void publish(const iot::mqtt::packets::Publish& publish);
+            void publish(std::shared_ptr<const iot::mqtt::packets::Publish> publish);
+            void acknowledged();
+
+            nlohmann::json getMetrics() const;
+
+        private:
+            bool mayPass(uint8_t qoS) const;
+            void send(const iot::mqtt::packets::Publish& publish);
+            void enqueue(std::shared_ptr<const iot::mqtt::packets::Publish> publish);
+            void drain();
+
+            Mqtt* mqtt;
+            OutboundOptions outboundOptions;
+            std::deque<std::shared_ptr<const iot::mqtt::packets::Publish>> queue;
+
+            std::size_t inflight = 0;
+            std::size_t sent = 0;
+            std::size_t acked = 0;
+            std::size_t dropped = 0;
+            std::size_t maxQueued = 0;
+        } outboundQueue;
+
+        core::timer::Timer outboxDrainTimer;
+
+        std::shared_ptr<bool> alive = std::make_shared<bool>(true); // expires mapping results delivered after destruction
+
         static std::set<Mqtt*> mqttInstances;
+
+        static std::shared_ptr<Outbox> outbox;
+        static std::size_t outboxDrainRate;
+        static Mqtt* outboxDrainer;
     };
 
 } // namespace mqtt::mqttintegrator::lib
@@ -0,0 +1,294 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "Outbox.h"
+
+#include <iot/mqtt/packets/Publish.h>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include "log/Logger.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string_view>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#endif
+
+namespace mqtt::mqttintegrator::lib {
+
+    namespace {
+
+        constexpr std::string_view OUTBOX_MAGIC{"MQSOBX1"};
+
+        // Record layout: uint32 record size | uint16 topic length | uint8 QoS | uint8 retain | topic | message
+        constexpr std::size_t RECORD_HEADER_SIZE = 8;
+
+        std::uint32_t readU32(const unsigned char* at) {
+            std::uint32_t value = 0;
+            std::memcpy(&value, at, sizeof(value));
+            return value;
+        }
+
+        std::uint16_t readU16(const unsigned char* at) {
+            std::uint16_t value = 0;
+            std::memcpy(&value, at, sizeof(value));
+            return value;
+        }
+
+    } // namespace
+
+    struct Outbox::Header {
+        char magic[8];
+        std::uint64_t capacity;
+        std::uint64_t head;  // offset of the oldest record
+        std::uint64_t tail;  // offset the next record is written to
+        std::uint64_t used;  // bytes occupied by records and wrap gaps
+        std::uint64_t count; // number of records
+    };
+
+    Outbox::Outbox(const std::string& fileName, std::size_t capacity, OverflowPolicy overflowPolicy)
+        : fileName(fileName)
+        , capacity(capacity)
+        , overflowPolicy(overflowPolicy)
+        , mappedSize(sizeof(Header) + capacity) {
+        if (capacity < RECORD_HEADER_SIZE) {
+            throw std::runtime_error("Outbox capacity of " + std::to_string(capacity) + " bytes is too small");
+        }
+
+        fd = ::open(fileName.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            throw std::runtime_error("Opening outbox '" + fileName + "' failed: " + std::strerror(errno));
+        }
+
+        if (::ftruncate(fd, static_cast<off_t>(mappedSize)) != 0) {
+            const int errnum = errno;
+            ::close(fd);
+            throw std::runtime_error("Sizing outbox '" + fileName + "' failed: " + std::strerror(errnum));
+        }
+
+        mapped = ::mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            const int errnum = errno;
+            ::close(fd);
+            throw std::runtime_error("Mapping outbox '" + fileName + "' failed: " + std::strerror(errnum));
+        }
+
+        header = static_cast<Header*>(mapped);
+        ring = static_cast<unsigned char*>(mapped) + sizeof(Header);
+
+        const bool valid = std::string_view(header->magic, OUTBOX_MAGIC.size()) == OUTBOX_MAGIC && header->capacity == capacity &&
+                           header->head < capacity && header->tail < capacity && header->used <= capacity &&
+                           header->count * RECORD_HEADER_SIZE <= header->used;
+        if (valid) {
+            VLOG(1) << "Outbox '" << fileName << "': " << header->count << " publishes recovered";
+        } else {
+            std::memset(header, 0, sizeof(Header));
+            std::memcpy(header->magic, OUTBOX_MAGIC.data(), OUTBOX_MAGIC.size());
+            header->capacity = capacity;
+
+            VLOG(1) << "Outbox '" << fileName << "': initialized with " << capacity << " bytes";
+        }
+    }
+
+    Outbox::~Outbox() {
+        ::msync(mapped, mappedSize, MS_SYNC);
+        ::munmap(mapped, mappedSize);
+        ::close(fd);
+    }
+
+    Outbox::OverflowPolicy Outbox::parseOverflowPolicy(const std::string& overflowPolicy) {
+        return overflowPolicy == "drop-new" ? OverflowPolicy::DROP_NEW : OverflowPolicy::DROP_OLDEST;
+    }
+
+    std::size_t Outbox::reserve(std::size_t recordSize) {
+        std::size_t offset = std::string::npos;
+
+        if (header->count == 0) {
+            header->head = header->tail = header->used = 0;
+            offset = 0;
+        } else if (header->tail > header->head) {
+            if (capacity - header->tail >= recordSize) {
+                offset = header->tail;
+            } else if (header->head >= recordSize) {
+                const std::size_t gap = capacity - header->tail;
+                if (gap >= sizeof(std::uint32_t)) {
+                    std::memset(ring + header->tail, 0, sizeof(std::uint32_t)); // wrap marker
+                }
+                header->used += gap;
+                header->tail = 0;
+                offset = 0;
+            }
+        } else if (header->head - header->tail >= recordSize) {
+            offset = header->tail;
+        }
+
+        return offset;
+    }
+
+    std::size_t Outbox::headRecord() {
+        if (capacity - header->head < RECORD_HEADER_SIZE || readU32(ring + header->head) == 0) {
+            header->used -= capacity - header->head;
+            header->head = 0;
+        }
+
+        const std::uint32_t recordSize = readU32(ring + header->head);
+        if (recordSize < RECORD_HEADER_SIZE || recordSize > header->used ||
+            RECORD_HEADER_SIZE + readU16(ring + header->head + 4) > recordSize) {
+            LOG(ERROR) << "Outbox '" << fileName << "': corrupted, " << header->count << " publishes discarded";
+
+            dropped += header->count;
+            header->head = header->tail = header->used = header->count = 0;
+        }
+
+        return header->head;
+    }
+
+    void Outbox::discardOldest() {
+        const std::size_t offset = headRecord();
+
+        if (header->count > 0) {
+            const std::uint32_t recordSize = readU32(ring + offset);
+
+            header->head = (offset + recordSize) % capacity;
+            header->used -= recordSize;
+            --header->count;
+        }
+    }
+
+    bool Outbox::push(const iot::mqtt::packets::Publish& publish) {
+        const std::string& topic = publish.getTopic();
+        const std::string& message = publish.getMessage();
+        const std::size_t recordSize = RECORD_HEADER_SIZE + topic.size() + message.size();
+
+        bool accepted = recordSize <= capacity && recordSize <= UINT32_MAX && topic.size() <= UINT16_MAX;
+
+        std::size_t offset = accepted ? reserve(recordSize) : std::string::npos;
+        while (accepted && offset == std::string::npos) {
+            if (overflowPolicy == OverflowPolicy::DROP_NEW) {
+                accepted = false;
+            } else {
+                discardOldest();
+                ++dropped;
+
+                offset = reserve(recordSize);
+            }
+        }
+
+        if (accepted) {
+            unsigned char* record = ring + offset;
+
+            const auto size = static_cast<std::uint32_t>(recordSize);
+            const auto topicLength = static_cast<std::uint16_t>(topic.size());
+            std::memcpy(record, &size, sizeof(size));
+            std::memcpy(record + 4, &topicLength, sizeof(topicLength));
+            record[6] = publish.getQoS();
+            record[7] = publish.getRetain() ? 1 : 0;
+            std::memcpy(record + RECORD_HEADER_SIZE, topic.data(), topic.size());
+            std::memcpy(record + RECORD_HEADER_SIZE + topic.size(), message.data(), message.size());
+
+            header->tail = (offset + recordSize) % capacity;
+            header->used += recordSize;
+            ++header->count;
+
+            ++pushed;
+        } else {
+            ++dropped;
+        }
+
+        return accepted;
+    }
+
+    std::shared_ptr<const iot::mqtt::packets::Publish> Outbox::front() {
+        std::shared_ptr<const iot::mqtt::packets::Publish> publish;
+
+        const std::size_t offset = header->count > 0 ? headRecord() : 0;
+        if (header->count > 0) {
+            const unsigned char* record = ring + offset;
+
+            const std::uint32_t recordSize = readU32(record);
+            const std::uint16_t topicLength = readU16(record + 4);
+            const char* topic = reinterpret_cast<const char*>(record + RECORD_HEADER_SIZE);
+
+            publish = std::make_shared<const iot::mqtt::packets::Publish>(0,
+                                                                          std::string(topic, topicLength),
+                                                                          std::string(topic + topicLength,
+                                                                                      recordSize - RECORD_HEADER_SIZE - topicLength),
+                                                                          record[6],
+                                                                          false,
+                                                                          record[7] != 0);
+        }
+
+        return publish;
+    }
+
+    void Outbox::pop() {
+        if (header->count > 0) {
+            discardOldest();
+
+            ++popped;
+        }
+    }
+
+    bool Outbox::empty() const {
+        return header->count == 0;
+    }
+
+    std::size_t Outbox::size() const {
+        return header->count;
+    }
+
+    nlohmann::json Outbox::getMetrics() const {
+        return {{"file", fileName},
+                {"capacity", capacity},
+                {"used", header->used},
+                {"queued", header->count},
+                {"pushed", pushed},
+                {"popped", popped},
+                {"dropped", dropped}};
+    }
+
+} // namespace mqtt::mqttintegrator::lib
@@ -0,0 +1,109 @@
+/*
+ * MQTTSuite - A lightweight MQTT Integration System
+ * Copyright (C) Volker Christian <me@vchrist.at>
+ *               2022, 2023, 2024, 2025, 2026
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef APPS_MQTTBROKER_MQTTINTEGRATOR_OUTBOX_H
+#define APPS_MQTTBROKER_MQTTINTEGRATOR_OUTBOX_H
+
+namespace iot::mqtt::packets {
+    class Publish;
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+
+#endif
+
+namespace mqtt::mqttintegrator::lib {
+
+    // Ring buffer of publishes in a memory mapped file of fixed size. It keeps QoS 1/2 output of the mapping while the upstream
+    // connection is down and survives a restart of the integrator. Records are stored contiguously; a record not fitting in
+    // front of the end of the ring leaves a gap and wraps to the start.
+    class Outbox {
+    public:
+        enum class OverflowPolicy { DROP_OLDEST, DROP_NEW };
+
+        Outbox(const std::string& fileName, std::size_t capacity, OverflowPolicy overflowPolicy); // can throw
+        Outbox(const Outbox&) = delete;
+        Outbox& operator=(const Outbox&) = delete;
+
+        ~Outbox();
+
+        static OverflowPolicy parseOverflowPolicy(const std::string& overflowPolicy); // drop-oldest or drop-new
+
+        bool push(const iot::mqtt::packets::Publish& publish); // false if the publish has been dropped
+        std::shared_ptr<const iot::mqtt::packets::Publish> front(); // nullptr if empty, the publish stays in the outbox
+        void pop();
+
+        bool empty() const;
+        std::size_t size() const;
+
+        nlohmann::json getMetrics() const;
+
+    private:
+        struct Header;
+
+        std::size_t reserve(std::size_t recordSize); // returns the write offset or npos
+        void discardOldest();
+        std::size_t headRecord(); // skips a gap at the head, returns the read offset
+
+        std::string fileName;
+        std::size_t capacity;
+        OverflowPolicy overflowPolicy;
+
+        int fd = -1;
+        std::size_t mappedSize = 0;
+        void* mapped = nullptr;
+        Header* header = nullptr;
+        unsigned char* ring = nullptr;
+
+        std::size_t pushed = 0;
+        std::size_t popped = 0;
+        std::size_t dropped = 0;
+    };
+
+} // namespace mqtt::mqttintegrator::lib
+
+#endif // APPS_MQTTBROKER_MQTTINTEGRATOR_OUTBOX_H
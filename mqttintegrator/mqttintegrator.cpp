@@ -83,13 +83,19 @@
 
 #include <log/Logger.h>
 //
+#include <cstddef>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
 #include <utility>
 
 #endif
 
 // admin API
+#include "lib/LoopMonitor.h"
 #include "lib/MappingAdminRouter.h"
 #include "lib/Mqtt.h"
+#include "lib/Outbox.h"
 
 namespace {
 
@@ -141,9 +147,13 @@ startClient(const std::string& instanceName,
     socketClient.getConfig()->setRetryBase(1);
     socketClient.getConfig()->setReconnect();
 
-    socketClient.connect([instanceName](const SocketAddress& socketAddress, const core::socket::State& state) {
-        reportState(instanceName, socketAddress, state);
-    });
+    // One connection per shard, each subscribing to its share of the subscriptions
+    const std::size_t shards = utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttIntegrator>()->getShards();
+    for (std::size_t shard = 0; shard < shards; ++shard) {
+        socketClient.connect([instanceName](const SocketAddress& socketAddress, const core::socket::State& state) {
+            reportState(instanceName, socketAddress, state);
+        });
+    }
 
     return socketClient;
 }
@@ -186,9 +196,12 @@ HttpClient startClient(const std::string& name, const std::function<void(typenam
     httpClient.getConfig()->setRetryBase(1);
     httpClient.getConfig()->setReconnect();
 
-    httpClient.connect([name](const SocketAddress& socketAddress, const core::socket::State& state) {
-        reportState(name, socketAddress, state);
-    });
+    const std::size_t shards = utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttIntegrator>()->getShards();
+    for (std::size_t shard = 0; shard < shards; ++shard) {
+        httpClient.connect([name](const SocketAddress& socketAddress, const core::socket::State& state) {
+            reportState(name, socketAddress, state);
+        });
+    }
 
     return httpClient;
 }
@@ -227,10 +240,44 @@ int main(int argc, char* argv[]) {
         return core::SNodeC::start();
     }
 
+    mqtt::lib::LoopMonitor::instance().start("integrator", configMqttIntegrator->getLoopReport());
+
+    if (!configMqttIntegrator->getOutbox().empty()) {
+        try {
+            mqtt::mqttintegrator::lib::Mqtt::setOutbox(
+                std::make_shared<mqtt::mqttintegrator::lib::Outbox>(
+                    configMqttIntegrator->getOutbox(),
+                    configMqttIntegrator->getOutboxSize(),
+                    mqtt::mqttintegrator::lib::Outbox::parseOverflowPolicy(configMqttIntegrator->getOutboxPolicy())),
+                configMqttIntegrator->getOutboxDrainRate());
+        } catch (const std::runtime_error& e) {
+            LOG(ERROR) << "Outbox disabled: " << e.what();
+        }
+    }
+
     // Instanciate Admin Router for Mapping Management
-    express::Router router =
-        mqtt::lib::admin::makeMappingAdminRouter(configMqttIntegrator, mqtt::lib::admin::AdminOptions{}, [](bool mustReconnect) {
+    express::Router router = mqtt::lib::admin::makeMappingAdminRouter(
+        configMqttIntegrator,
+        mqtt::lib::admin::AdminOptions{},
+        [](bool mustReconnect) {
             return mqtt::mqttintegrator::lib::Mqtt::updateSubscriptions(mustReconnect);
+        },
+        [](express::Router& api) {
+            // GET /metrics/outbound (inflight window and send queue per upstream connection)
+            api.get("/metrics/outbound", [] APPLICATION(req, res) {
+                res->status(200).json(mqtt::mqttintegrator::lib::Mqtt::getOutboundMetrics());
+            });
+
+            // GET /metrics/loop (event loop lag, wall time of onPublish and the admin handlers)
+            api.get("/metrics/loop", [] APPLICATION(req, res) {
+                res->status(200).json(mqtt::lib::LoopMonitor::instance().toJson());
+            });
+
+            // POST /metrics/loop/reset
+            api.post("/metrics/loop/reset", [] APPLICATION(req, res) {
+                mqtt::lib::LoopMonitor::instance().reset();
+                res->status(200).json({{"reset", true}});
+            });
         });
 
     express::legacy::in::Server("in-http", router, reportState, [](net::in::stream::legacy::config::ConfigSocketServer* config) {
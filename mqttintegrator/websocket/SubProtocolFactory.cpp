@@ -63,11 +63,20 @@ namespace mqtt::mqttintegrator::websocket {
     iot::mqtt::client::SubProtocol* SubProtocolFactory::create(web::websocket::SubProtocolContext* subProtocolContext) {
         mqtt::lib::ConfigMqttIntegrator* config = utils::Config::configRoot.getSubCommand<mqtt::lib::ConfigMqttIntegrator>();
 
+        const mqtt::mqttintegrator::lib::Mqtt::OutboundOptions outboundOptions{
+            config->getInflightWindow(),
+            config->getSendQueue(),
+            mqtt::mqttintegrator::lib::Mqtt::OutboundOptions::parseOverflowPolicy(config->getOverflowPolicy())};
+
         return new iot::mqtt::client::SubProtocol(
             subProtocolContext,
             getName(),
-            new mqtt::mqttintegrator::lib::Mqtt(
-                subProtocolContext->getSocketConnection()->getConnectionName(), config->getMqttMapper(), config->getSessionStore()));
+            new mqtt::mqttintegrator::lib::Mqtt(subProtocolContext->getSocketConnection()->getConnectionName(),
+                                                subProtocolContext->getSocketConnection()->getInstanceName(),
+                                                config->getMappingNamespaces(),
+                                                config->getSessionStore(),
+                                                config->getShards(),
+                                                outboundOptions));
     }
 
 } // namespace mqtt::mqttintegrator::websocket